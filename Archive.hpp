@@ -0,0 +1,418 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <cstdlib>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Bits.hpp"
+#include "PuzzleIO.hpp"
+
+// A packed puzzle archive. All integers are little-endian.
+//
+//   header   "SDKA", u32 version, u32 flags (1: records hold solutions)
+//   records  81-bit given mask (11 bytes, bit k for cell k), then the
+//            givens' digits in cell order, two per byte, low nibble first;
+//            with solutions, then the blanks' solution digits the same way
+//            (all 0 when the puzzle has none)
+//   index    u64 file offset of every 64th record, from record 0
+//   trailer  u64 index offset, u64 record count, "SDKA"
+//
+// A 25-clue puzzle takes 24 bytes, 52 with its solution, against 82 and
+// 164 as text. The trailer comes last so an archive can be written to a
+// pipe; reading needs the whole file.
+namespace archive {
+static const char magic[4] = { 'S', 'D', 'K', 'A' };
+static const unsigned version = 1;
+static const unsigned with_solutions = 1;
+static const unsigned header_size = 12, trailer_size = 20, mask_size = 11;
+static const unsigned index_every = 64;
+
+static inline void put32(unsigned char * p, std::uint32_t v) {
+    for (unsigned k = 0; k < 4; ++k)
+        p[k] = static_cast<unsigned char>(v >> 8 * k);
+}
+static inline void put64(unsigned char * p, std::uint64_t v) {
+    for (unsigned k = 0; k < 8; ++k)
+        p[k] = static_cast<unsigned char>(v >> 8 * k);
+}
+static inline std::uint32_t get32(const unsigned char * p) {
+    std::uint32_t v = 0;
+    for (unsigned k = 4; k-- > 0;)
+        v = v << 8 | p[k];
+    return v;
+}
+static inline std::uint64_t get64(const unsigned char * p) {
+    std::uint64_t v = 0;
+    for (unsigned k = 8; k-- > 0;)
+        v = v << 8 | p[k];
+    return v;
+}
+}
+
+// Writes an archive through an OutputBuffer. finish() writes the index and
+// the trailer; nothing else may be written to `out` in between.
+class ArchiveWriter {
+public:
+    ArchiveWriter(std::FILE * out, bool solutions)
+        : _out(out), _solutions(solutions), _offset(0), _count(0) {
+        unsigned char header[archive::header_size];
+        std::memcpy(header, archive::magic, 4);
+        archive::put32(header + 4, archive::version);
+        archive::put32(header + 8, solutions ? archive::with_solutions : 0);
+        _write(header, archive::header_size);
+    }
+    // `solution` is ignored without solutions, and may be 0 for a puzzle
+    // that has none
+    void add(const unsigned char puzzle[81], const unsigned char solution[81] = 0) {
+        if (_count % archive::index_every == 0)
+            _index.push_back(_offset);
+        ++_count;
+        unsigned char record[archive::mask_size + 82];
+        std::memset(record, 0, sizeof record);
+        unsigned size = archive::mask_size, nibble = 0;
+        for (unsigned k = 0; k < 81; ++k)
+            if (puzzle[k]) {
+                record[k / 8] |= static_cast<unsigned char>(1u << k % 8);
+                _nibble(record, size, nibble, puzzle[k]);
+            }
+        if (_solutions) {
+            size += (nibble + 1) / 2;
+            nibble = 0;
+            for (unsigned k = 0; k < 81; ++k)
+                if (!puzzle[k])
+                    _nibble(record, size, nibble, solution ? solution[k] : 0);
+        }
+        _write(record, size + (nibble + 1) / 2);
+    }
+    unsigned long long count() const {
+        return _count;
+    }
+    void finish() {
+        std::uint64_t index_offset = _offset;
+        unsigned char word[8];
+        for (std::size_t k = 0; k < _index.size(); ++k) {
+            archive::put64(word, _index[k]);
+            _write(word, 8);
+        }
+        unsigned char trailer[archive::trailer_size];
+        archive::put64(trailer, index_offset);
+        archive::put64(trailer + 8, _count);
+        std::memcpy(trailer + 16, archive::magic, 4);
+        _write(trailer, archive::trailer_size);
+        _out.flush();
+    }
+private:
+    OutputBuffer _out;
+    bool _solutions;
+    std::uint64_t _offset;
+    unsigned long long _count;
+    std::vector<std::uint64_t> _index;
+
+    // Packs digit number `nibble` of the run that starts at `base`
+    static void _nibble(unsigned char * record, unsigned base, unsigned & nibble, unsigned digit) {
+        record[base + nibble / 2] |= static_cast<unsigned char>(digit << 4 * (nibble % 2));
+        ++nibble;
+    }
+    void _write(const unsigned char * data, unsigned length) {
+        _out.write(reinterpret_cast<const char *>(data), length);
+        _offset += length;
+    }
+};
+
+// Maps an archive into memory and decodes its records in place, with no
+// per-record allocation or formatted I/O. Records are read in order from
+// any starting record; seek() goes through the index.
+class ArchiveReader {
+public:
+    ArchiveReader()
+        : _data(0), _size(0), _count(0), _next(0), _error("no archive open") {
+    }
+    ~ArchiveReader() {
+        close();
+    }
+    // False if `name` cannot be read or is not a valid archive; error()
+    // says why
+    bool open(const char * name) {
+        close();
+        if (!_map(name))
+            return false;
+        if (_size < archive::header_size + archive::trailer_size ||
+                std::memcmp(_data, archive::magic, 4) != 0 ||
+                std::memcmp(_data + _size - 4, archive::magic, 4) != 0)
+            return _reject("not a puzzle archive");
+        if (archive::get32(_data + 4) != archive::version)
+            return _reject("unsupported archive version");
+        _solutions = (archive::get32(_data + 8) & archive::with_solutions) != 0;
+        const unsigned char * trailer = _data + _size - archive::trailer_size;
+        _index_offset = archive::get64(trailer);
+        _count = archive::get64(trailer + 8);
+        std::uint64_t blocks = (_count + archive::index_every - 1) / archive::index_every;
+        if (_index_offset < archive::header_size ||
+                _index_offset > _size - archive::trailer_size ||
+                _size - archive::trailer_size - _index_offset != 8 * blocks)
+            return _reject("corrupt archive index");
+        _error = 0;
+        return seek(0);
+    }
+    void close() {
+        if (_data)
+            _unmap();
+        _data = 0;
+        _size = 0;
+        _count = _next = 0;
+        _error = "no archive open";
+    }
+    const char * error() const {
+        return _error;
+    }
+    unsigned long long count() const {
+        return _count;
+    }
+    bool has_solutions() const {
+        return _solutions;
+    }
+    // The number of the record next() reads next
+    unsigned long long position() const {
+        return _next;
+    }
+    bool seek(unsigned long long record) {
+        if (record > _count)
+            return _fail("record out of range");
+        unsigned long long block = record / archive::index_every;
+        _next = block * archive::index_every;
+        _pos = _next < _count ? archive::get64(_data + _index_offset + 8 * block)
+                              : _index_offset;
+        while (_next < record)
+            if (!next(0, 0))
+                return false;
+        return true;
+    }
+    // Decodes the next record into `puzzle` and, if the archive has them,
+    // `solution` (either may be 0 to skip it). False at the end, or on a
+    // corrupt record, which sets error().
+    bool next(unsigned char puzzle[81], unsigned char solution[81]) {
+        if (_next == _count)
+            return false;
+        const unsigned char * mask = _data + _pos;
+        if (_pos + archive::mask_size > _index_offset || mask[10] & 0xFE)
+            return _fail("corrupt record");
+        // The mask as three words of 32 cells, so the loops below visit
+        // only the cells they fill. bitCount takes nine bits, hence bytes.
+        bitfield words[3] = { 0, 0, 0 };
+        unsigned givens = 0;
+        for (unsigned k = 0; k < archive::mask_size; ++k) {
+            words[k / 4] |= static_cast<bitfield>(mask[k]) << 8 * (k % 4);
+            givens += bitCount(mask[k]);
+        }
+        std::uint64_t size = archive::mask_size + (givens + 1) / 2 +
+                             (_solutions ? (82 - givens) / 2 : 0);
+        if (_pos + size > _index_offset)
+            return _fail("corrupt record");
+        if (puzzle || solution) {
+            unsigned char cells[81];
+            unsigned char * out = puzzle ? puzzle : cells;
+            if (!_decode(words, mask + archive::mask_size, out, true))
+                return false;
+            if (solution) {
+                std::memcpy(solution, out, 81);
+                if (_solutions) {
+                    bitfield blanks[3] = { ~words[0], ~words[1], ~words[2] & 0x1FFFF };
+                    if (!_decode(blanks, mask + archive::mask_size + (givens + 1) / 2,
+                                 solution, false))
+                        return false;
+                }
+            }
+        }
+        _pos += size;
+        ++_next;
+        return true;
+    }
+private:
+    const unsigned char * _data;
+    std::uint64_t _size, _index_offset, _pos;
+    unsigned long long _count, _next;
+    bool _solutions;
+    const char * _error;
+#ifdef _WIN32
+    std::vector<unsigned char> _buffer;
+#endif
+
+    // Fills the cells set in `words` from consecutive nibbles, into a
+    // zeroed grid when `givens`, over the givens already there otherwise
+    bool _decode(const bitfield words[3], const unsigned char * nibbles,
+                 unsigned char cells[81], bool givens) {
+        if (givens)
+            std::memset(cells, 0, 81);
+        unsigned n = 0;
+        for (unsigned w = 0; w < 3; ++w)
+            for (bitfield bits = words[w]; bits; bits &= bits - 1, ++n) {
+                unsigned d = nibbles[n / 2] >> 4 * (n % 2) & 15;
+                if (d > 9 || (givens && !d))
+                    return _fail("corrupt record");
+                cells[32 * w + numFor(bits & (0u - bits)) - 1] = static_cast<unsigned char>(d);
+            }
+        return true;
+    }
+    bool _fail(const char * why) {
+        _error = why;
+        return false;
+    }
+    bool _reject(const char * why) {
+        close();
+        return _fail(why);
+    }
+#ifdef _WIN32
+    bool _map(const char * name) {
+        std::FILE * in = std::fopen(name, "rb");
+        if (!in)
+            return _fail("cannot open file");
+        _buffer.clear();
+        unsigned char chunk[1 << 16];
+        std::size_t got;
+        while ((got = std::fread(chunk, 1, sizeof chunk, in)) != 0)
+            _buffer.insert(_buffer.end(), chunk, chunk + got);
+        std::fclose(in);
+        if (_buffer.empty())
+            return _fail("not a puzzle archive");
+        _data = _buffer.data();
+        _size = _buffer.size();
+        return true;
+    }
+    void _unmap() {
+        std::vector<unsigned char>().swap(_buffer);
+    }
+#else
+    bool _map(const char * name) {
+        int fd = ::open(name, O_RDONLY);
+        if (fd < 0)
+            return _fail("cannot open file");
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            return _fail("cannot open file");
+        }
+        if (info.st_size <= 0) {
+            ::close(fd);
+            return _fail("not a puzzle archive");
+        }
+        void * data = ::mmap(0, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return _fail("cannot map file");
+        ::madvise(data, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+        _data = static_cast<const unsigned char *>(data);
+        _size = static_cast<std::uint64_t>(info.st_size);
+        return true;
+    }
+    void _unmap() {
+        ::munmap(const_cast<unsigned char *>(_data), static_cast<std::size_t>(_size));
+    }
+#endif
+};
+
+// Whether the file open on `in` starts like an archive. Leaves it at the
+// start.
+static inline bool is_archive(std::FILE * in) {
+    char head[4];
+    bool packed = std::fread(head, 1, 4, in) == 4 && std::memcmp(head, archive::magic, 4) == 0;
+    std::rewind(in);
+    return packed;
+}
+
+// Whether `solution` is a complete grid that keeps the givens of `puzzle`
+static inline bool solves(const unsigned char puzzle[81], const unsigned char solution[81]) {
+    bitfield rows[9] = {0}, cols[9] = {0}, boxes[9] = {0};
+    for (unsigned k = 0; k < 81; ++k) {
+        unsigned i = k / 9, j = k % 9, b = i / 3 * 3 + j / 3;
+        if (!solution[k] || (puzzle[k] && puzzle[k] != solution[k]))
+            return false;
+        bitfield bit = bitFor(solution[k]);
+        if ((rows[i] | cols[j] | boxes[b]) & bit)
+            return false;
+        rows[i] |= bit;
+        cols[j] |= bit;
+        boxes[b] |= bit;
+    }
+    return true;
+}
+
+// Packs text puzzles from `puzzles`, in either format PuzzleParser reads,
+// into an archive on `out`. With `solutions`, the archive holds solutions
+// too, taken line for line from that file as `Sudoku -b` writes them: one
+// line per puzzle, malformed ones included, empty for a puzzle without a
+// solution. A malformed puzzle is reported on `err` and left out, along
+// with its solution line; a solution that does not solve its puzzle is
+// reported and the puzzle packed without it. Returns the number of puzzles
+// packed.
+static inline unsigned long long pack_text(std::FILE * puzzles, std::FILE * solutions,
+                                           std::FILE * out, std::FILE * err) {
+    LineReader reader(puzzles);
+    std::unique_ptr<LineReader> answers(solutions ? new LineReader(solutions) : 0);
+    ArchiveWriter writer(out, solutions != 0);
+    PuzzleParser parser;
+    const char * line;
+    unsigned length;
+    unsigned char puzzle[81], solution[81];
+    PuzzleParser::status status;
+    while ((status = parser.next(reader, puzzle)) != PuzzleParser::MORE) {
+        bool solved = false;
+        if (answers && answers->next(line, length)) {
+            while (length && (line[length - 1] == '\r' || line[length - 1] == ' ' ||
+                              line[length - 1] == '\t'))
+                --length;
+            solved = parse_line(line, length, solution);
+            if (status == PuzzleParser::PUZZLE && length && !(solved && solves(puzzle, solution))) {
+                std::fprintf(err, "line %lu: solution does not solve the puzzle on line %lu\n",
+                             answers->line_number(), parser.first_line());
+                solved = false;
+            }
+        }
+        if (status == PuzzleParser::FAILED) {
+            std::fprintf(err, "line %lu: %s\n", parser.error().line, parser.error().message);
+            continue;
+        }
+        writer.add(puzzle, solved ? solution : 0);
+    }
+    writer.finish();
+    return writer.count();
+}
+
+// Unpacks an archive into one-line text, '.' for blanks: puzzles to
+// `puzzles` and, if `solutions` is given, solutions line for line to it,
+// with an empty line where there is none. Returns false on a corrupt
+// record.
+static inline bool unpack_text(ArchiveReader & reader, std::FILE * puzzles, std::FILE * solutions) {
+    OutputBuffer puzzle_out(puzzles);
+    std::unique_ptr<OutputBuffer> solution_out(solutions ? new OutputBuffer(solutions) : 0);
+    unsigned char puzzle[81], solution[81];
+    char text[82];
+    while (reader.next(puzzle, solution)) {
+        format_line(puzzle, text);
+        puzzle_out.write(text, 82);
+        if (!solution_out)
+            continue;
+        bool complete = true;
+        for (unsigned k = 0; k < 81; ++k)
+            complete = complete && solution[k];
+        format_line(solution, text);
+        if (complete)
+            solution_out->write(text, 82);
+        else
+            solution_out->put('\n');
+    }
+    return reader.position() == reader.count();
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <memory>
+
+#include "Archive.hpp"
+#include "Lockstep.hpp"
+#include "PuzzleCache.hpp"
+#include "PuzzleIO.hpp"
+#include "Solver.hpp"
+#include "ThreadPool.hpp"
+
+// Solves one puzzle given as 81 cells (0 for blanks) with the chosen engine.
+// Returns false if the givens clash or the puzzle has no solution.
+// `answer` may be the same array as `puzzle`. The pipeline adds what it
+// did to `stats` when one is given.
+static bool solve_cells(const unsigned char puzzle[81], unsigned char answer[81],
+                        engine e = PIPELINE, SolveStats * stats = 0) {
+    Board board;
+    board.stats_to(stats);
+    if (!load_cells(puzzle, board) || !solve_board(board, e))
+        return false;
+    for (unsigned k = 0; k < 81; ++k)
+        answer[k] = static_cast<unsigned char>(board.get_num(k / 9, k % 9));
+    return true;
+}
+
+enum solve_status { SOLVED, MALFORMED, NO_SOLUTION };
+
+// Streams puzzles from `in` and writes one solution line per
+// puzzle to `out`, in input order. Puzzles are read in chunks and, with more
+// than one thread, solved on a work-stealing pool while a bounded window of
+// chunks is in flight, so memory use is fixed regardless of the input size.
+// Puzzles are one line or a nine-line grid each (see PuzzleParser); a
+// puzzle that is malformed or has no solution yields an empty line and a
+// note on `err` with its line number and, if malformed, what is wrong.
+// With `lockstep`, each chunk first goes through singles sixteen puzzles at
+// a time, and only the puzzles that stall are handed to the engine.
+// With `stats`, every puzzle is timed and its solver stats are added to it
+// in input order; lock-step lanes cannot be timed one by one, so this
+// solves every puzzle with the engine alone. With `cache`, puzzles (or the
+// lanes lock-step leaves) are answered through it instead of the engine,
+// except while stats are taken.
+class BatchSolver {
+public:
+    static const unsigned chunk_size = 256;
+
+    unsigned long solved, failed;
+
+    BatchSolver(std::FILE * in, std::FILE * out, std::FILE * err,
+                unsigned threads = 1, engine e = PIPELINE, bool lockstep = false,
+                BatchStats * stats = 0, PuzzleCache * cache = 0)
+        : solved(0), failed(0), _reader(in), _writer(out), _err(err),
+          _threads(threads ? threads : 1), _engine(e), _lockstep(lockstep && !stats),
+          _stats(stats), _cache(cache), _archive(0) {
+    }
+    // Takes the puzzles from `archive` instead of the input stream; they
+    // are numbered by record, from 1, where lines would be. A corrupt
+    // record ends the input, with the reader's position left on it.
+    void read_from(ArchiveReader * archive) {
+        _archive = archive;
+    }
+    void run() {
+        if (_threads == 1) {
+            std::unique_ptr<Chunk> chunk(new Chunk);
+            while (_fill(*chunk)) {
+                _solve(*chunk);
+                _write(*chunk);
+            }
+        } else {
+            _run_parallel();
+        }
+        _writer.flush();
+    }
+private:
+    struct Chunk {
+        unsigned count;
+        bool done;
+        unsigned char cells[chunk_size][81];
+        unsigned char status[chunk_size];
+        unsigned long lines[chunk_size];
+        const char * errors[chunk_size];
+        unsigned long long ns[chunk_size];
+        SolveStats stats[chunk_size];
+    };
+
+    LineReader _reader;
+    PuzzleParser _parser;
+    OutputBuffer _writer;
+    std::FILE * _err;
+    unsigned _threads;
+    engine _engine;
+    bool _lockstep;
+    BatchStats * _stats;
+    PuzzleCache * _cache;
+    ArchiveReader * _archive;
+    std::mutex _done_lock;
+    std::condition_variable _done;
+
+    bool _fill(Chunk & chunk) {
+        chunk.count = 0;
+        if (_archive) {
+            while (chunk.count < chunk_size && _archive->next(chunk.cells[chunk.count], 0)) {
+                chunk.lines[chunk.count] = static_cast<unsigned long>(_archive->position());
+                chunk.status[chunk.count++] = SOLVED;
+            }
+            return chunk.count != 0;
+        }
+        while (chunk.count < chunk_size) {
+            unsigned k = chunk.count;
+            PuzzleParser::status status = _parser.next(_reader, chunk.cells[k]);
+            if (status == PuzzleParser::MORE)
+                break;
+            ++chunk.count;
+            if (status == PuzzleParser::PUZZLE) {
+                chunk.lines[k] = _parser.first_line();
+                chunk.status[k] = SOLVED;
+            } else {
+                chunk.lines[k] = _parser.error().line;
+                chunk.errors[k] = _parser.error().message;
+                chunk.status[k] = MALFORMED;
+            }
+        }
+        return chunk.count != 0;
+    }
+    void _solve(Chunk & chunk) {
+        if (_lockstep) {
+            _solve_lockstep(chunk);
+            return;
+        }
+        if (_stats) {
+            _solve_timed(chunk);
+            return;
+        }
+        for (unsigned k = 0; k < chunk.count; ++k)
+            if (chunk.status[k] == SOLVED && !_solve_one(chunk.cells[k]))
+                chunk.status[k] = NO_SOLUTION;
+    }
+    bool _solve_one(unsigned char cells[81]) {
+        if (!_cache)
+            return solve_cells(cells, cells, _engine);
+        PuzzleFacts facts;
+        _cache->solve(cells, facts);
+        if (!facts.solutions)
+            return false;
+        std::memcpy(cells, facts.solution, 81);
+        return true;
+    }
+    void _solve_timed(Chunk & chunk) {
+        for (unsigned k = 0; k < chunk.count; ++k) {
+            if (chunk.status[k] != SOLVED)
+                continue;
+            chunk.stats[k].clear();
+            StatsClock::time_point start = StatsClock::now();
+            if (!solve_cells(chunk.cells[k], chunk.cells[k], _engine, &chunk.stats[k]))
+                chunk.status[k] = NO_SOLUTION;
+            chunk.ns[k] = static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - start).count());
+        }
+    }
+    void _solve_lockstep(Chunk & chunk) {
+        Lockstep group;
+        unsigned lanes[Lockstep::width];
+        unsigned k = 0;
+        while (k < chunk.count) {
+            group.clear();
+            unsigned used = 0;
+            for (; k < chunk.count && used < Lockstep::width; ++k) {
+                if (chunk.status[k] != SOLVED)
+                    continue;
+                if (group.load(used, chunk.cells[k]))
+                    lanes[used++] = k;
+                else
+                    chunk.status[k] = NO_SOLUTION;
+            }
+            group.propagate();
+            // Singles only ever place forced digits, so a stalled lane can
+            // be finished from where it stopped
+            for (unsigned l = 0; l < used; ++l) {
+                unsigned char * cells = chunk.cells[lanes[l]];
+                if (!group.extract(l, cells) && !_solve_one(cells))
+                    chunk.status[lanes[l]] = NO_SOLUTION;
+            }
+        }
+    }
+    void _write(Chunk & chunk) {
+        char text[82];
+        for (unsigned k = 0; k < chunk.count; ++k) {
+            if (_stats && chunk.status[k] != MALFORMED)
+                _stats->record(chunk.lines[k], chunk.ns[k], chunk.stats[k]);
+            if (chunk.status[k] != SOLVED) {
+                _writer.put('\n');
+                std::fprintf(_err, "line %lu: %s\n", chunk.lines[k],
+                             chunk.status[k] == MALFORMED ? chunk.errors[k] : "no solution");
+                ++failed;
+                continue;
+            }
+            format_line(chunk.cells[k], text);
+            _writer.write(text, 82);
+            ++solved;
+        }
+    }
+    void _finish(Chunk & chunk) {
+        std::lock_guard<std::mutex> guard(_done_lock);
+        chunk.done = true;
+        _done.notify_all();
+    }
+    void _wait(Chunk & chunk) {
+        std::unique_lock<std::mutex> guard(_done_lock);
+        _done.wait(guard, [&chunk] { return chunk.done; });
+    }
+    void _run_parallel() {
+        // Enough chunks in flight to keep every worker busy while the
+        // oldest one is waited on and written out
+        unsigned window = 4 * _threads;
+        std::vector<Chunk> slots(window);
+        ThreadPool pool(_threads);
+        unsigned long issued = 0, written = 0;
+        while (true) {
+            if (issued - written == window) {
+                Chunk & oldest = slots[written++ % window];
+                _wait(oldest);
+                _write(oldest);
+            }
+            Chunk & chunk = slots[issued % window];
+            if (!_fill(chunk))
+                break;
+            chunk.done = false;
+            pool.submit([this, &chunk] {
+                _solve(chunk);
+                _finish(chunk);
+            });
+            ++issued;
+        }
+        while (written < issued) {
+            Chunk & oldest = slots[written++ % window];
+            _wait(oldest);
+            _write(oldest);
+        }
+    }
+};
+
+#endif
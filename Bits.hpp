@@ -0,0 +1,102 @@
+#ifndef BITS_H
+#define BITS_H
+
+// Candidate sets are 9-bit masks: bit (num - 1) stands for num.
+typedef unsigned bitfield;
+// Storage form of a bitfield, for masks kept in large arrays
+typedef unsigned short bitfield16;
+
+static const bitfield maskMax = 512;
+static const bitfield allSet = 511;
+
+// The hot bit operations use the compiler's popcount/ctz when it has them
+// (C++20 <bit>, GCC/Clang builtins or MSVC intrinsics) and plain loops
+// otherwise. Define SUDOKU_PORTABLE_BITS to force the loops, e.g. to
+// measure the difference.
+#if defined(SUDOKU_PORTABLE_BITS)
+#define SUDOKU_BITS "portable"
+#elif __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<bit>)
+#include <bit>
+#define SUDOKU_BITS_STD 1
+#define SUDOKU_BITS "std::popcount"
+#endif
+#endif
+
+#if !defined(SUDOKU_BITS) && (defined(__GNUC__) || defined(__clang__))
+#define SUDOKU_BITS_BUILTIN 1
+#define SUDOKU_BITS "__builtin_popcount"
+#elif !defined(SUDOKU_BITS) && defined(_MSC_VER)
+#include <intrin.h>
+#define SUDOKU_BITS_MSVC 1
+#define SUDOKU_BITS "__popcnt"
+#elif !defined(SUDOKU_BITS)
+#define SUDOKU_BITS "portable"
+#endif
+
+// Returns the size of the set
+static inline unsigned bitCount(bitfield bits) {
+#if defined(SUDOKU_BITS_STD)
+    return static_cast<unsigned>(std::popcount(bits));
+#elif defined(SUDOKU_BITS_BUILTIN)
+    return static_cast<unsigned>(__builtin_popcount(bits));
+#elif defined(SUDOKU_BITS_MSVC)
+    return __popcnt(bits);
+#else
+    unsigned result = 0;
+    bitfield mask = 1;
+
+    while(mask != maskMax) {
+        if (bits & mask)
+            result++;
+        mask *= 2;
+    }
+
+    return result;
+#endif
+}
+
+// Returns a bitfield representing {num}
+static inline bitfield bitFor(unsigned num) {
+    return 1 << (num - 1);
+}
+
+// Returns num for a bitfield representing {num}
+static inline unsigned numFor(bitfield bit) {
+#if defined(SUDOKU_BITS_STD)
+    return static_cast<unsigned>(std::countr_zero(bit)) + 1;
+#elif defined(SUDOKU_BITS_BUILTIN)
+    return static_cast<unsigned>(__builtin_ctz(bit)) + 1;
+#elif defined(SUDOKU_BITS_MSVC)
+    unsigned long index;
+    _BitScanForward(&index, bit);
+    return static_cast<unsigned>(index) + 1;
+#else
+    unsigned num = 0;
+    while (bit) {
+        bit >>= 1;
+        ++num;
+    }
+    return num;
+#endif
+}
+
+// Returns the index of the highest set bit of a nonzero value
+static inline unsigned highBit(unsigned long long value) {
+#if defined(SUDOKU_BITS_STD)
+    return 63 - static_cast<unsigned>(std::countl_zero(value));
+#elif defined(SUDOKU_BITS_BUILTIN)
+    return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#elif defined(SUDOKU_BITS_MSVC) && defined(_WIN64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    unsigned top = 0;
+    while (value >>= 1)
+        ++top;
+    return top;
+#endif
+}
+
+#endif
@@ -1,7 +1,19 @@
 #ifndef BOARD_H
 #define BOARD_H
 
-#include <list>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+#include "Bits.hpp"
+#include "CandidateGrid.hpp"
+#include "PuzzleIO.hpp"
+#include "Random.hpp"
+#include "Stats.hpp"
+#include "Trace.hpp"
 
 class Candidate {
 public:
@@ -41,8 +53,121 @@ public:
         return blocks[i/3][j/3];
     }
 private:
-    bitfield rows[9], cols[9];
-    bitfield blocks[3][3];
+    bitfield16 rows[9], cols[9];
+    bitfield16 blocks[3][3];
+};
+
+// Where a trailed board can be rolled back to; see Board::mark
+struct TrailMark {
+    unsigned size, level;
+    std::uint64_t parent;
+    unsigned changed;
+};
+
+// The undo log of a board attached with Board::trail_to. While a mark is
+// open, the first change after it to a cell's digit or to its candidates
+// saves the old value, so rolling back costs one entry per changed cell
+// rather than a copy of the board. At most `depth` marks may be open at
+// once, which bounds the log and keeps it allocation-free; opening one
+// more aborts.
+class Trail {
+public:
+    static const unsigned depth = 8;
+    // A cell's digit, then its candidates
+    static const unsigned slots = 2 * 81;
+
+    Trail()
+        : _size(0), _open(0), _epoch(0), _epochs(0) {
+        std::memset(_stamps, 0, sizeof _stamps);
+    }
+    // Saves `old` for `slot` unless no mark is open or it was saved since
+    // the innermost one
+    void save(unsigned slot, unsigned old) {
+        if (!_epoch || _stamps[slot] == _epoch)
+            return;
+        if (_size == capacity)
+            _fail("trail log overflow");
+        Entry & e = _entries[_size++];
+        e.slot = static_cast<unsigned char>(slot);
+        e.old = static_cast<bitfield16>(old);
+        e.stamp = _stamps[slot];
+        _stamps[slot] = _epoch;
+    }
+private:
+    friend class Board;
+
+    // Each open mark saves a slot at most once
+    static const unsigned capacity = depth * slots;
+
+    // The stamp the slot had before, put back on undo so an enclosing
+    // mark does not save the slot again
+    struct Entry {
+        std::uint64_t stamp;
+        unsigned char slot;
+        bitfield16 old;
+    };
+
+    Entry _entries[capacity];
+    unsigned _size, _open;
+    // Stamps the slots saved in the innermost region; 0 is no region.
+    // Epochs are 64-bit so they never wrap into a stamp still in use.
+    std::uint64_t _stamps[slots];
+    std::uint64_t _epoch, _epochs;
+
+    void _mark(TrailMark & m) {
+        if (_open == depth)
+            _fail("more than Trail::depth marks open");
+        m.size = _size;
+        m.level = _open++;
+        m.parent = _epoch;
+        _epoch = ++_epochs;
+    }
+    void _undo(const TrailMark & m) {
+        _epoch = m.parent;
+        _open = m.level;
+    }
+    static void _fail(const char * what) {
+        std::fprintf(stderr, "Board: %s\n", what);
+        std::abort();
+    }
+};
+
+// What a board attached with Board::log_steps_to did in its last
+// advanced_step: the single that placed each cell, and for each house the
+// techniques whose eliminations touched one of its cells. A placement is
+// credited with its single and the eliminations in its own houses.
+class StepLog {
+public:
+    // Marks a cell the step did not place
+    static const unsigned char none = 0xFF;
+
+    StepLog() {
+        clear();
+    }
+    void clear() {
+        std::memset(_singles, none, sizeof _singles);
+        std::memset(_houses, 0, sizeof _houses);
+    }
+    void placed(unsigned row, unsigned col, technique single) {
+        _singles[9 * row + col] = static_cast<unsigned char>(single);
+    }
+    void eliminated(unsigned row, unsigned col, technique t) {
+        _houses[row] |= 1u << t;
+        _houses[9 + col] |= 1u << t;
+        _houses[18 + row / 3 * 3 + col / 3] |= 1u << t;
+    }
+    bool placed(unsigned row, unsigned col) const {
+        return _singles[9 * row + col] != none;
+    }
+    // Bit t for each technique credited with placing the cell
+    unsigned techniques(unsigned row, unsigned col) const {
+        return 1u << _singles[9 * row + col] | _houses[row] | _houses[9 + col] |
+               _houses[18 + row / 3 * 3 + col / 3];
+    }
+private:
+    unsigned char _singles[81];
+    // Rows, then columns, then blocks
+    unsigned _houses[27];
 };
 
 class Board {
@@ -52,34 +177,106 @@ public:
 
     Board()
         : remains(81), solutions(0) {
+        trace_to(0);
+        stats_to(0);
+        trail_to(0);
+        log_steps_to(0);
         for (unsigned i = 0; i < 9; ++i)
             for (unsigned j = 0; j < 9; ++j) {
                 matrix[i][j] = 0;
                 memory[i][j] = allSet;
             }
     }
-    Board(unsigned seed)
+    // A random complete grid drawn from `rng`
+    explicit Board(Random & rng)
         : remains(81), solutions(0) {
+        trace_to(0);
+        stats_to(0);
+        trail_to(0);
+        log_steps_to(0);
         for (unsigned i = 0; i < 9; ++i)
             for (unsigned j = 0; j < 9; ++j) {
                 matrix[i][j] = 0;
                 memory[i][j] = allSet;
             }
 
-        std::srand(seed);
-        _random_fill();
+        _random_fill(rng);
     }
-    void set(unsigned row, unsigned col, unsigned val, bool advanced = false) {
-        matrix[row][col] = val;
-        if (matrix[row][col]) {
-            Blank.elim(row, col, val);
-            --remains;
+    // Sends solving steps to `sink` (0 for none). A no-op unless the build
+    // has SUDOKU_TRACE. Boards used from several threads must not share a
+    // sink.
+    void trace_to(TraceSink * sink) {
+#if SUDOKU_TRACE
+        _trace = sink;
+#else
+        (void)sink;
+#endif
+    }
+    // Adds what the following solving steps cost to `stats` (0 to stop).
+    // A no-op when the build has SUDOKU_STATS set to 0. Like a trace sink,
+    // one SolveStats must not be shared between threads.
+    void stats_to(SolveStats * stats) {
+#if SUDOKU_STATS
+        _stats = stats;
+#else
+        (void)stats;
+#endif
+    }
+    // Logs changes to `trail` (0 for none) so mark and undo can roll the
+    // board back. Copies of the board log to the same trail, so a copy
+    // that outlives or leaves the trailed code should be detached.
+    void trail_to(Trail * trail) {
+        _trail = trail;
+    }
+    // Records in `log` (0 for none) what each advanced_step places and
+    // which eliminations led there; see StepLog
+    void log_steps_to(StepLog * log) {
+        _log = log;
+    }
+    // Opens a region of the trail; undo(mark()) later puts back every
+    // digit, candidate and remaining count changed since, along with the
+    // step state. Requires a trail.
+    TrailMark mark() {
+        TrailMark m;
+        _trail->_mark(m);
+        m.changed = _changed;
+        return m;
+    }
+    // Rolls back to `m` and closes it and every mark opened after it
+    void undo(const TrailMark & m) {
+        while (_trail->_size > m.size) {
+            const Trail::Entry & e = _trail->_entries[--_trail->_size];
+            _trail->_stamps[e.slot] = e.stamp;
+            unsigned cell = e.slot % 81;
+            unsigned row = cell / 9, col = cell % 9;
+            if (e.slot >= 81) {
+                memory[row][col] = e.old;
+                continue;
+            }
+            if (matrix[row][col]) {
+                Blank.cancel(row, col, matrix[row][col]);
+                ++remains;
+            }
+            matrix[row][col] = static_cast<unsigned char>(e.old);
+            if (e.old) {
+                Blank.elim(row, col, e.old);
+                --remains;
+            }
         }
+        _trail->_undo(m);
+        _changed = m.changed;
+    }
+    // The public mode flags below pick a specialized instantiation once per
+    // call, so no mode is tested inside the solving loops
+    void set(unsigned row, unsigned col, unsigned val, bool advanced = false) {
         if (advanced)
-            _update(row, col);
+            _set<true>(row, col, val);
+        else
+            _set<false>(row, col, val);
     }
     unsigned unset(unsigned row, unsigned col) {
         unsigned val = matrix[row][col];
+        _save_digit(row, col);
         if (val) {
             Blank.cancel(row, col, val);
             ++remains;
@@ -91,30 +288,13 @@ public:
         return Blank.possible(i, j) & mask & memory[i][j];
     }
     bitfield house_check(unsigned i, unsigned j, bool advanced = false) {
-        bitfield house_hidden = Blank.block(i, j);
-        unsigned row_base = i / 3 * 3;
-        unsigned col_base = j / 3 * 3;
-        for (unsigned row = row_base; row < row_base + 3; ++row)
-            for (unsigned col = col_base; col < col_base + 3; ++col) {
-                if ((row == i && col == j) || matrix[row][col])
-                    continue;
-                house_hidden &= advanced ? ~memory[row][col] : ~Blank.possible(row, col);
-            }
-        return house_hidden;
+        return advanced ? _house_check<true>(i, j) : _house_check<false>(i, j);
     }
     bitfield row_check(unsigned i, unsigned j, bool advanced = false) {
-        bitfield row_hidden = Blank.row(i);
-        for (unsigned col = 0; col < 9; ++col)
-            if (!matrix[i][col] && col != j)
-                row_hidden &= advanced ? ~memory[i][col] : ~Blank.possible(i, col);
-        return row_hidden;
+        return advanced ? _row_check<true>(i, j) : _row_check<false>(i, j);
     }
     bitfield col_check(unsigned i, unsigned j, bool advanced = false) {
-        bitfield col_hidden = Blank.col(j);
-        for (unsigned row = 0; row < 9; ++row)
-            if (!matrix[row][j] && row != i)
-                col_hidden &= advanced ? ~memory[row][j] : ~Blank.possible(row, j);
-        return col_hidden;
+        return advanced ? _col_check<true>(i, j) : _col_check<false>(i, j);
     }
     bitfield decide(bitfield & possible, bitfield & house,
                     bitfield & row,      bitfield & col) {
@@ -152,122 +332,14 @@ public:
         return 0;
     }
     bool hidden_fill(bool hint = false) {
-        bool again;
-        output << std::endl << "Simple solving ";
-        do {
-            again = false;
-            output << ".";
-            unsigned loc, i, j;
-            for (unsigned pos = 0; pos < 81; ++pos) {
-                loc = 4 * pos % 81;
-                i = loc / 9, j = loc % 9;
-                if (matrix[i][j]) continue;
-                bitfield possible = Blank.possible(i, j);
-                bitfield house = house_check(i, j);
-                bitfield row = row_check(i, j);
-                bitfield col = col_check(i, j);
-                bitfield to_check = decide(possible, house, row, col);
-                if (to_check) {
-                    set(i, j, numFor(to_check));
-                    if (hint) {
-                        one_step = 9 * i + j;
-                        return true;
-                    } else {
-                        again = true;
-                    }
-                }
-            }
-        } while (again);
-        return false;
+        BOARD_PHASE(HIDDEN_FILL);
+        return hint ? _hidden_fill<true>() : _hidden_fill<false>();
     }
+    // Locked candidates for the row and the column through (i, j) inside
+    // its block
     void candidate_check(unsigned i, unsigned j) {
-        bitfield row_locked(0), col_locked(0), row_i(0), col_j(0);
-        unsigned row_base = i / 3 * 3;
-        unsigned col_base = j / 3 * 3;
-
-        //Locked Candidate Type 1 (Pointing)
-        unsigned total_count = 0;
-        for (unsigned row = row_base; row < row_base + 3; ++row) {
-            if (row == i) {
-                for (unsigned col = col_base; col < col_base + 3; ++col) {
-                    if (matrix[row][col])
-                        continue;
-                    row_i |= memory[row][col];
-                }
-            } else {
-                for (unsigned col = col_base; col < col_base + 3; ++col) {
-                    if (matrix[row][col])
-                        continue;
-                    row_locked |= memory[row][col];
-                    ++total_count;
-                }
-            }
-        }
-        if (total_count && total_count == bitCount(row_locked))
-            memory[i][j] &= ~row_locked;
-        bitfield pointing = row_i & ~row_locked;
-        if (pointing)
-            for (unsigned col = 0; col < 9; ++col) {
-                if (matrix[i][col] || (col >= col_base && col < col_base + 3))
-                    continue;
-                memory[i][col] &= ~pointing;
-            }
-
-        total_count = 0;
-        for (unsigned col = col_base; col < col_base + 3; ++col) {
-            if (col == j) {
-                for (unsigned row = row_base; row < row_base + 3; ++row) {
-                    if (matrix[row][col])
-                        continue;
-                    col_j |= memory[row][col];
-                }
-            } else {
-                for (unsigned row = row_base; row < row_base + 3; ++row) {
-                    if (matrix[row][col])
-                        continue;
-                    col_locked |= memory[row][col];
-                    ++total_count;
-                }
-            }
-        }
-        if (total_count && total_count == bitCount(col_locked))
-            memory[i][j] &= ~col_locked;
-        pointing = col_j & ~col_locked;
-        if (pointing)
-            for (unsigned row = 0; row < 9; ++row) {
-                if (matrix[row][j] || (row >= row_base && row < row_base + 3))
-                    continue;
-                memory[row][j] &= ~pointing;
-            }
-
-        //Locked Candidate Type 2 (Claiming)
-        for (unsigned col = 0; col < 9; ++col) {
-            if (matrix[i][col] || (col >= col_base && col < col_base + 3))
-                continue;
-            row_i &= ~memory[i][col];
-        }
-        if (row_i) {
-            for (unsigned r = row_base; r < row_base + 3; ++r)
-                for (unsigned c = col_base; c < col_base + 3; ++c) {
-                    if (r == i || matrix[r][c])
-                        continue;
-                    memory[r][c] &= ~row_i;
-                }
-        }
-
-        for (unsigned row = 0; row < 9; ++row) {
-            if (matrix[row][j] || (row >= row_base && row < row_base + 3))
-                continue;
-            col_j &= ~memory[row][j];
-        }
-        if (col_j) {
-            for (unsigned r = row_base; r < row_base + 3; ++r)
-                for (unsigned c = col_base; c < col_base + 3; ++c) {
-                    if (c == j || matrix[r][c])
-                        continue;
-                    memory[r][c] &= ~col_j;
-                }
-        }
+        _locked_row(i, j / 3 * 3);
+        _locked_col(i / 3 * 3, j);
     }
     void pair_check(unsigned i, unsigned j) {
         bitfield value = memory[i][j];
@@ -286,7 +358,7 @@ public:
                 for (unsigned col = 0; col < 9; ++col) {
                     if (matrix[i][col] || col == j || col == match_c)
                         continue;
-                    memory[i][col] &= ~value;
+                    _eliminate(i, col, value, NAKED_PAIR);
                 }
 
             //Naked Pair in Column
@@ -301,7 +373,7 @@ public:
                 for (unsigned row = 0; row < 9; ++row) {
                     if (matrix[row][j] || row == i || row == match_r)
                         continue;
-                    memory[row][j] &= ~value;
+                    _eliminate(row, j, value, NAKED_PAIR);
                 }
 
             match_r = 9, match_c = 9;
@@ -325,54 +397,50 @@ public:
                         if (matrix[row][col] || (row == i && col == j) ||
                                 (row == match_r && col == match_c))
                             continue;
-                        memory[row][col] &= ~value;
+                        _eliminate(row, col, value, NAKED_PAIR);
                     }
                 }
         }
     }
-    bool advanced_fill(bool hint = false) {
-        bool again;
-        unsigned sum;
-        output << std::endl << "Advanced solving ";
+    // Alternates the locked-candidate and naked-pair rules with singles.
+    // Every elimination and placement records the houses it changed, and
+    // each round re-runs the rules only on the block segments and cells in
+    // those houses. When a round changes nothing, the stronger rules up to
+    // `strongest` are tried in the order of the technique enum, which is
+    // cheapest first: hidden pairs, naked triples, hidden triples, X-Wing,
+    // naked quads, XY-Wing and Swordfish. The first one that eliminates
+    // anything hands the houses it changed back to the basic rules, and the
+    // fill stops once none applies.
+    bool advanced_fill(bool hint = false, technique strongest = NAKED_PAIR) {
+        BOARD_PHASE(ADVANCED_FILL);
+        return hint ? _advanced_fill<true>(strongest) : _advanced_fill<false>(strongest);
+    }
+    // Narrows every open cell's candidates to its peers and marks every
+    // house as changed, so advanced_step can take the board from here.
+    void start_steps() {
         for (unsigned i = 0; i < 9; ++i)
             for (unsigned j = 0; j < 9; ++j)
-                if (!matrix[i][j])
+                if (!matrix[i][j]) {
+                    _save_memory(i, j);
                     memory[i][j] &= Blank.possible(i, j);
-
-        do {
-            again = false;
-            output << ".";
-            sum = 0;
-            unsigned loc, i, j;
-            for (i = 0; i < 9; ++i)
-                for (j = 0; j < 9; ++j)
-                    sum += memory[i][j];
-
-            for (unsigned pos = 0; pos < 81; ++pos) {
-                loc = 4 * pos % 81;
-                i = loc / 9, j = loc % 9;
-                if (matrix[i][j]) continue;
-                candidate_check(i, j);
-                pair_check(i, j);
-                bitfield possible = memory[i][j];
-                bitfield house = house_check(i, j, true);
-                bitfield row = row_check(i, j, true);
-                bitfield col = col_check(i, j, true);
-                bitfield to_check = decide(possible, house, row, col);
-                if (to_check) {
-                    set(i, j, numFor(to_check), true);
-                    if (hint) {
-                        one_step = 9 * i + j;
-                        return true;
-                    }
                 }
-            }
-
-            for (i = 0; i < 9; ++i)
-                for (j = 0; j < 9; ++j)
-                    sum -= memory[i][j];
-            if (sum) again = true;
-        } while (again);
+        _changed = (1u << 27) - 1;
+    }
+    // Places every single showing on the board, running the rules up to
+    // `strongest` only until one shows; false when none does. Unlike
+    // advanced_fill(true) it keeps the candidates and the changed houses
+    // from earlier steps, and placements made with set(..., true) narrow
+    // them too, so a step only reruns the rules over the houses that
+    // changed since the last one.
+    bool advanced_step(technique strongest = SWORDFISH) {
+        BOARD_PHASE(ADVANCED_FILL);
+        CandidateGrid grid;
+        if (_log)
+            _log->clear();
+        do {
+            if (_memory_singles<false>(grid))
+                return true;
+        } while (_rules_round(strongest));
         return false;
     }
     bool reasonable(unsigned i, unsigned j) {
@@ -411,64 +479,269 @@ public:
         return solutions;
     }
     bool backtrack(bool multiple = false) {
+        BOARD_PHASE(BACKTRACK);
         backtrack_count = 0;
+        _open_count = 0;
         for (unsigned i = 0; i < 9; ++i)
             for (unsigned j = 0; j < 9; ++j) {
                 if (!matrix[i][j]) {
                     unsigned count = bitCount(Blank.possible(i, j) & memory[i][j]);
                     if (count < 3) {
-                        if (!count) return false;
-                        countList.push_front(9 * i + j);
+                        if (!count) {
+                            BOARD_STATS(dead_end());
+                            return false;
+                        }
+                        _enlist(i, j);
                     } else {
-                        countList.push_back(9 * i + j);
+                        _open_cells[_open_count++] = static_cast<unsigned char>(9 * i + j);
                     }
                 }
             }
-        _btrack(remaining(), multiple);
-        output << "\nAnd totally " << backtrack_count
-               << " backtracking attempt(s)." << std::endl;
+        BOARD_STATS(search_begin(remaining()));
+        if (multiple)
+            _btrack<true>(remaining());
+        else
+            _btrack<false>(remaining());
+        BOARD_TRACE(searched(backtrack_count, solutions != 0));
         return solutions != 0;
     }
+    // Counts the solutions of the current grid, stopping as soon as `limit`
+    // are found. The board is searched in place and left exactly as it was,
+    // so this costs one search and no copy.
+    unsigned count_solutions(unsigned limit = 2) {
+        _open_count = 0;
+        for (unsigned i = 0; i < 9; ++i)
+            for (unsigned j = 0; j < 9; ++j)
+                if (!matrix[i][j]) {
+                    if (!mask_check(i, j, allSet))
+                        return 0;
+                    _open_cells[_open_count++] = static_cast<unsigned char>(9 * i + j);
+                }
+        // The search undoes itself, so it need not be logged
+        Trail * trail = _trail;
+        _trail = 0;
+        unsigned found = 0;
+        _count(limit ? limit : 1, found);
+        _trail = trail;
+        return found;
+    }
     bool assert(unsigned i, unsigned j, unsigned val) {
         return matrix[i][j] == val;
     }
     unsigned get_num(unsigned i, unsigned j) {
         return matrix[i][j];
     }
+    // Writes the grid in one call; the stream is not flushed
     void print_board(std::ostream & out) {
-        for (unsigned i = 0; i < 9; ++i) {
-            for (unsigned j = 0; j < 9; ++j)
-                out << matrix[i][j] << " ";
-            out << std::endl;
-        }
-        out << std::endl;
+        char text[grid_text_size];
+        format_grid(&matrix[0][0], text);
+        out.write(text, grid_text_size);
     }
 private:
-    unsigned matrix[9][9];
-    bitfield memory[9][9];
-    unsigned remains, solutions;
+    // Packed so that a copy is a single memcpy of a few cache lines
+    unsigned char matrix[9][9];
+    unsigned char remains;
+    unsigned char _open_count;
+    bitfield16 memory[9][9];
     Candidate Blank;
-    std::list<int> countList;
+    unsigned solutions;
+    // Unfilled cells still to be searched, in the order findMin breaks ties
+    unsigned char _open_cells[81];
+    // Houses (rows, then columns, then blocks) whose cells changed since
+    // advanced_fill last ran its rules over them
+    unsigned _changed;
+#if SUDOKU_TRACE
+    TraceSink * _trace;
+#endif
+#if SUDOKU_STATS
+    SolveStats * _stats;
+#endif
+    Trail * _trail;
+    StepLog * _log;
+
+    void _save_digit(unsigned row, unsigned col) {
+        if (_trail)
+            _trail->save(9 * row + col, matrix[row][col]);
+    }
+    void _save_memory(unsigned row, unsigned col) {
+        if (_trail)
+            _trail->save(81 + 9 * row + col, memory[row][col]);
+    }
 
-    static unsigned numFor(bitfield bit) {
-        unsigned num = 0;
-        while (bit) {
-            bit >>= 1;
-            ++num;
+    template <bool Advanced>
+    void _set(unsigned row, unsigned col, unsigned val) {
+        _save_digit(row, col);
+        matrix[row][col] = static_cast<unsigned char>(val);
+        if (matrix[row][col]) {
+            Blank.elim(row, col, val);
+            --remains;
         }
-        return num;
+        if (Advanced)
+            _update(row, col);
+    }
+    // The digits an open cell can still take: its candidates, narrowed by
+    // the advanced rules when `Advanced`
+    template <bool Advanced>
+    bitfield _open_digits(unsigned row, unsigned col) {
+        return Advanced ? memory[row][col] : Blank.possible(row, col);
+    }
+    template <bool Advanced>
+    bitfield _house_check(unsigned i, unsigned j) {
+        bitfield house_hidden = Blank.block(i, j);
+        unsigned row_base = i / 3 * 3;
+        unsigned col_base = j / 3 * 3;
+        for (unsigned row = row_base; row < row_base + 3; ++row)
+            for (unsigned col = col_base; col < col_base + 3; ++col) {
+                if ((row == i && col == j) || matrix[row][col])
+                    continue;
+                house_hidden &= ~_open_digits<Advanced>(row, col);
+            }
+        return house_hidden;
+    }
+    template <bool Advanced>
+    bitfield _row_check(unsigned i, unsigned j) {
+        bitfield row_hidden = Blank.row(i);
+        for (unsigned col = 0; col < 9; ++col)
+            if (!matrix[i][col] && col != j)
+                row_hidden &= ~_open_digits<Advanced>(i, col);
+        return row_hidden;
+    }
+    template <bool Advanced>
+    bitfield _col_check(unsigned i, unsigned j) {
+        bitfield col_hidden = Blank.col(j);
+        for (unsigned row = 0; row < 9; ++row)
+            if (!matrix[row][j] && row != i)
+                col_hidden &= ~_open_digits<Advanced>(row, j);
+        return col_hidden;
+    }
+    template <bool Hint>
+    bool _hidden_fill() {
+        bool again;
+        CandidateGrid grid;
+        do {
+            again = false;
+            BOARD_TRACE(pass(HIDDEN_FILL));
+            _candidates(grid, false);
+            unsigned loc, i, j;
+            for (unsigned pos = 0; pos < 81; ++pos) {
+                loc = 4 * pos % 81;
+                i = loc / 9, j = loc % 9;
+                if (matrix[i][j]) continue;
+                bitfield possible = grid.cells[i][j];
+                bitfield house = grid.block_single[i / 3 * 3 + j / 3];
+                bitfield row = grid.row_single[i];
+                bitfield col = grid.col_single[j];
+                bitfield to_check = decide(possible, house, row, col);
+                // The grid predates this pass's placements, so recheck
+                if (to_check && (Blank.possible(i, j) & to_check)) {
+                    _set<false>(i, j, numFor(to_check));
+                    BOARD_TRACE(placed(bitCount(possible) == 1 ? NAKED_SINGLE : HIDDEN_SINGLE,
+                                       9 * i + j, numFor(to_check)));
+                    BOARD_STATS(fired(bitCount(possible) == 1 ? NAKED_SINGLE : HIDDEN_SINGLE));
+                    if (Hint) {
+                        one_step = 9 * i + j;
+                        return true;
+                    } else {
+                        again = true;
+                    }
+                }
+            }
+        } while (again);
+        return false;
+    }
+    template <bool Hint>
+    bool _advanced_fill(technique strongest) {
+        start_steps();
+        return _advanced_rounds<Hint>(strongest);
+    }
+    // The rounds of advanced_fill, each followed by the singles it shows
+    template <bool Hint>
+    bool _advanced_rounds(technique strongest) {
+        CandidateGrid grid;
+        while (_rules_round(strongest))
+            if (_memory_singles<Hint>(grid) && Hint)
+                return true;
+        return false;
+    }
+    // Runs the rules over the houses in _changed, which it empties and its
+    // eliminations fill again. The stronger rules run only when no house
+    // changed. False when nothing changed at all.
+    bool _rules_round(technique strongest) {
+        // The stronger rules, one per technique from HIDDEN_PAIR on
+        static const Rule rules[] = {
+            &Board::_hidden_subsets<2>, &Board::_naked_subsets<3>,
+            &Board::_hidden_subsets<3>, &Board::_fish<2>, &Board::_naked_subsets<4>,
+            &Board::_xy_wing, &Board::_fish<3>
+        };
+        for (unsigned k = 0; !_changed && HIDDEN_PAIR + k <= unsigned(strongest); ++k)
+            (this->*rules[k])();
+        if (!_changed)
+            return false;
+        unsigned changed = _changed;
+        _changed = 0;
+        BOARD_TRACE(pass(ADVANCED_FILL));
+        // Each row and column segment of a block depends only on that
+        // line and that block
+        for (unsigned b = 0; b < 9; ++b) {
+            unsigned row_base = b / 3 * 3, col_base = b % 3 * 3;
+            for (unsigned k = 0; k < 3; ++k) {
+                if (changed & (1u << (row_base + k) | 1u << (18 + b)))
+                    _locked_row(row_base + k, col_base);
+                if (changed & (1u << (9 + col_base + k) | 1u << (18 + b)))
+                    _locked_col(row_base, col_base + k);
+            }
+        }
+        for (unsigned pos = 0; pos < 81; ++pos) {
+            unsigned loc = 4 * pos % 81;
+            unsigned i = loc / 9, j = loc % 9;
+            if (!matrix[i][j] && (_houses_of(i, j) & changed))
+                pair_check(i, j);
+        }
+        return true;
+    }
+    // Places the singles of the candidates in memory and tells whether
+    // there were any. A hint stops at the first one and records it in
+    // one_step.
+    template <bool Hint>
+    bool _memory_singles(CandidateGrid & grid) {
+        _candidates(grid, true);
+        bool placed = false;
+        unsigned loc, i, j;
+        for (unsigned pos = 0; pos < 81; ++pos) {
+            loc = 4 * pos % 81;
+            i = loc / 9, j = loc % 9;
+            if (matrix[i][j]) continue;
+            bitfield possible = grid.cells[i][j];
+            bitfield house = grid.block_single[i / 3 * 3 + j / 3];
+            bitfield row = grid.row_single[i];
+            bitfield col = grid.col_single[j];
+            bitfield to_check = decide(possible, house, row, col);
+            if (to_check && mask_check(i, j, to_check)) {
+                technique single = bitCount(possible) == 1 ? NAKED_SINGLE : HIDDEN_SINGLE;
+                _set<true>(i, j, numFor(to_check));
+                BOARD_TRACE(placed(single, 9 * i + j, numFor(to_check)));
+                BOARD_STATS(fired(single));
+                if (_log)
+                    _log->placed(i, j, single);
+                placed = true;
+                if (Hint) {
+                    one_step = 9 * i + j;
+                    return true;
+                }
+            }
+        }
+        return placed;
     }
     bool findMin(unsigned& row, unsigned& col, bool & unique) {
-        unsigned count = 10;
+        unsigned count = 10, chosen = 0;
 
-        std::list<int>::iterator it, chosen;
-        for (it = countList.begin(); it != countList.end(); ++it) {
-            int loc = *it;
+        for (unsigned k = 0; k < _open_count; ++k) {
+            unsigned loc = _open_cells[k];
             row = loc / 9, col = loc % 9;
             unsigned newCount = bitCount(Blank.possible(row, col) & memory[row][col]);
             if(count > newCount) {
                 count = newCount;
-                chosen = it;
+                chosen = k;
                 if (count == 1) {
                     unique = true;
                     break;
@@ -479,21 +752,23 @@ private:
         }
 
         if (count != 10) {
-            int loc = *chosen;
+            unsigned loc = _open_cells[chosen];
             row = loc / 9, col = loc % 9;
-            countList.erase(chosen);
+            --_open_count;
+            std::memmove(_open_cells + chosen, _open_cells + chosen + 1, _open_count - chosen);
             return true;
         } else {
             return false;
         }
     }
-    bool _btrack(unsigned depth, const bool & multiple) {
+    template <bool Multiple>
+    bool _btrack(unsigned depth) {
         unsigned row, col;
         bool unique = false;
-        if (!findMin(row, col, unique))
+        if (!findMin(row, col, unique)) {
             if (!depth) {
                 ++solutions;
-                if (multiple) {
+                if (Multiple) {
                     if (solutions > 1)
                         return true;
                     return false;
@@ -501,99 +776,425 @@ private:
                     return true;
                 }
             } else {
+                BOARD_STATS(dead_end());
                 return false;
             }
+        }
 
         // Iterate through the possible values this cell could have
-        unsigned num = 1;
-        bitfield mask = bitFor(num);
+        bitfield possible = mask_check(row, col, allSet);
         ++backtrack_count;
+        BOARD_STATS(node(depth));
 
-        while (mask != maskMax) {
-            if (mask_check(row, col, mask)) {
-                set(row, col, num);
-                if (reasonable(row, col) && _btrack(depth - 1, multiple))
-                    return true;
-                unset(row, col);
-                if (unique)
-                    break;
-            }
-
-            // Advance to the next number
-            mask *= 2;
-            num++;
+        while (possible) {
+            bitfield mask = possible & (0 - possible);
+            possible &= ~mask;
+            _set<false>(row, col, numFor(mask));
+            if (!reasonable(row, col))
+                BOARD_STATS(dead_end());
+            else if (_btrack<Multiple>(depth - 1))
+                return true;
+            unset(row, col);
+            if (unique)
+                break;
         }
         _enlist(row, col);
         return false;
     }
+    // Computes the candidates of every cell (limited by memory when
+    // `advanced`) and the hidden singles of every house in one pass.
+    void _candidates(CandidateGrid & grid, bool advanced) {
+        lane_t rows[9], cols[16], blocks[9], open[9][16];
+        for (unsigned k = 0; k < 9; ++k) {
+            rows[k] = static_cast<lane_t>(Blank.row(k));
+            cols[k] = static_cast<lane_t>(Blank.col(k));
+            blocks[k] = static_cast<lane_t>(Blank.block(k / 3 * 3, k % 3 * 3));
+        }
+        for (unsigned k = 9; k < 16; ++k)
+            cols[k] = 0;
+        for (unsigned i = 0; i < 9; ++i) {
+            for (unsigned j = 0; j < 9; ++j)
+                open[i][j] = static_cast<lane_t>(matrix[i][j] ? 0 : advanced ? memory[i][j] : allSet);
+            for (unsigned j = 9; j < 16; ++j)
+                open[i][j] = 0;
+        }
+        grid.compute(rows, cols, blocks, open);
+    }
+    // Returns true once `limit` solutions have been counted. Every
+    // placement is undone on the way out.
+    bool _count(unsigned limit, unsigned & found) {
+        unsigned row, col;
+        bool unique = false;
+        if (!_open_count) {
+            ++found;
+            return found >= limit;
+        }
+        if (!findMin(row, col, unique))
+            return false;
+
+        bool done = false;
+        bitfield possible = mask_check(row, col, allSet);
+        while (possible && !done) {
+            bitfield mask = possible & (0 - possible);
+            possible &= ~mask;
+            _set<false>(row, col, numFor(mask));
+            done = reasonable(row, col) && _count(limit, found);
+            unset(row, col);
+        }
+        _enlist(row, col);
+        return done;
+    }
+    void _eliminate(unsigned row, unsigned col, bitfield digits, technique t) {
+        if (memory[row][col] & digits) {
+            BOARD_TRACE(eliminated(t, 9 * row + col, memory[row][col] & digits));
+            BOARD_STATS(fired(t));
+            if (_log)
+                _log->eliminated(row, col, t);
+            _save_memory(row, col);
+            memory[row][col] &= ~digits;
+            _changed |= _houses_of(row, col);
+        }
+    }
+    // Narrows the peers of a placement and records the houses that changed
     void _update(unsigned row, unsigned col) {
         unsigned row_base = row / 3 * 3;
         unsigned col_base = col / 3 * 3;
         unsigned r, c;
 
+        _changed |= _houses_of(row, col);
         for (unsigned i = 0; i < 9; ++i) {
             if (!matrix[row][i])
-                memory[row][i] &= Blank.possible(row, i);
+                _narrow(row, i);
             if (!matrix[i][col])
-                memory[i][col] &= Blank.possible(i, col);
+                _narrow(i, col);
             r = row_base + i / 3;
             c = col_base + i % 3;
             if (r != row && c != col && !matrix[r][c])
-                memory[r][c] &= Blank.possible(r, c);
+                _narrow(r, c);
         }
     }
-    void _enlist(unsigned row, unsigned col) {
-        countList.push_front(9 * row + col);
+    void _narrow(unsigned row, unsigned col) {
+        bitfield possible = Blank.possible(row, col);
+        if (memory[row][col] & ~possible) {
+            _save_memory(row, col);
+            memory[row][col] &= possible;
+            _changed |= _houses_of(row, col);
+        }
     }
-    bool _fill(bool is_big, unsigned block, unsigned num) {
-        if (is_big) {
-            if (num == 10)
-                return true;
-            if (block == 9)
-                return _fill(is_big, 0, num + 1);
+    // Row i inside the block starting at col_base. Locked set: if the other
+    // two rows of the block hold as many open cells as candidates, those
+    // candidates are not in row i's cells. Pointing: digits the block can
+    // only place in row i leave the rest of the row. Claiming: digits the
+    // row can only place in this block leave the block's other rows.
+    void _locked_row(unsigned i, unsigned col_base) {
+        bitfield segment = 0, others = 0;
+        unsigned open = 0, total_count = 0;
+        unsigned row_base = i / 3 * 3;
+        for (unsigned row = row_base; row < row_base + 3; ++row)
+            for (unsigned col = col_base; col < col_base + 3; ++col) {
+                if (matrix[row][col])
+                    continue;
+                if (row == i) {
+                    segment |= memory[row][col];
+                    ++open;
+                } else {
+                    others |= memory[row][col];
+                    ++total_count;
+                }
+            }
+        if (!open)
+            return;
+
+        if (total_count && total_count == bitCount(others))
+            for (unsigned col = col_base; col < col_base + 3; ++col)
+                if (!matrix[i][col])
+                    _eliminate(i, col, others, LOCKED_SET);
+        bitfield pointing = segment & ~others;
+        bitfield claiming = segment;
+        for (unsigned col = 0; col < 9; ++col) {
+            if (matrix[i][col] || (col >= col_base && col < col_base + 3))
+                continue;
+            if (pointing)
+                _eliminate(i, col, pointing, POINTING);
+            claiming &= ~memory[i][col];
         }
-        if (block == 9)
-            return true;
-        static unsigned look_up[] = {
-            0,  1,  2,
-            9,  10, 11,
-            18, 19, 20
-        };
-        static unsigned base[] = {
-            0,  3,  6,
-            27, 30, 33,
-            54, 57, 60
-        };
-        unsigned place;
-        bitfield available = allSet;
-        while (available) {
-            while (true) {
-                place = std::rand() % 9;
-                if (available & bitFor(place + 1))
-                    break;
+        if (claiming)
+            for (unsigned row = row_base; row < row_base + 3; ++row)
+                for (unsigned col = col_base; col < col_base + 3; ++col) {
+                    if (row == i || matrix[row][col])
+                        continue;
+                    _eliminate(row, col, claiming, CLAIMING);
+                }
+    }
+    // The same for column j inside the block starting at row_base
+    void _locked_col(unsigned row_base, unsigned j) {
+        bitfield segment = 0, others = 0;
+        unsigned open = 0, total_count = 0;
+        unsigned col_base = j / 3 * 3;
+        for (unsigned col = col_base; col < col_base + 3; ++col)
+            for (unsigned row = row_base; row < row_base + 3; ++row) {
+                if (matrix[row][col])
+                    continue;
+                if (col == j) {
+                    segment |= memory[row][col];
+                    ++open;
+                } else {
+                    others |= memory[row][col];
+                    ++total_count;
+                }
             }
-            available &= ~bitFor(place + 1);
-
-            unsigned loc = base[(2 * block) % 9] + look_up[place];
-            unsigned row = loc / 9, col = loc % 9;
-            if (!matrix[row][col] &&
-                    (bitFor(num) & Blank.possible(row, col))) {
-                set(row, col, num);
-                if (_fill(is_big, block + 1, num))
-                    return true;
-                unset(row, col);
+        if (!open)
+            return;
+
+        if (total_count && total_count == bitCount(others))
+            for (unsigned row = row_base; row < row_base + 3; ++row)
+                if (!matrix[row][j])
+                    _eliminate(row, j, others, LOCKED_SET);
+        bitfield pointing = segment & ~others;
+        bitfield claiming = segment;
+        for (unsigned row = 0; row < 9; ++row) {
+            if (matrix[row][j] || (row >= row_base && row < row_base + 3))
+                continue;
+            if (pointing)
+                _eliminate(row, j, pointing, POINTING);
+            claiming &= ~memory[row][j];
+        }
+        if (claiming)
+            for (unsigned row = row_base; row < row_base + 3; ++row)
+                for (unsigned col = col_base; col < col_base + 3; ++col) {
+                    if (col == j || matrix[row][col])
+                        continue;
+                    _eliminate(row, col, claiming, CLAIMING);
+                }
+    }
+    typedef void (Board::*Rule)();
+
+    // Cell m of house h, where houses 0-8 are the rows, 9-17 the columns
+    // and 18-26 the blocks
+    static void _house_cell(unsigned h, unsigned m, unsigned & row, unsigned & col) {
+        if (h < 9) {
+            row = h, col = m;
+        } else if (h < 18) {
+            row = m, col = h - 9;
+        } else {
+            row = (h - 18) / 3 * 3 + m / 3;
+            col = (h - 18) % 3 * 3 + m % 3;
+        }
+    }
+    static bool _sees(unsigned a, unsigned b) {
+        unsigned ra = a / 9, ca = a % 9, rb = b / 9, cb = b % 9;
+        return ra == rb || ca == cb || (ra / 3 == rb / 3 && ca / 3 == cb / 3);
+    }
+    // Calls found(chosen, cover) for every choice of N of the `count` sets
+    // whose union `cover` has exactly N members; `chosen` has bit k for
+    // sets[k]. Sets that are empty or larger than N are never chosen.
+    template <unsigned N, class Found>
+    static void _subsets(const bitfield * sets, unsigned count, Found & found,
+                         unsigned from = 0, unsigned size = 0,
+                         unsigned chosen = 0, bitfield cover = 0) {
+        if (size == N) {
+            if (bitCount(cover) == N)
+                found(chosen, cover);
+            return;
+        }
+        for (unsigned k = from; k + N - size <= count; ++k) {
+            bitfield next = cover | sets[k];
+            if (sets[k] && bitCount(next) <= N)
+                _subsets<N>(sets, count, found, k + 1, size + 1, chosen | 1u << k, next);
+        }
+    }
+    // N cells of a house that hold only N digits between them take those
+    // digits from the house's other cells
+    template <unsigned N>
+    void _naked_subsets() {
+        const technique t = N == 2 ? NAKED_PAIR : N == 3 ? NAKED_TRIPLE : NAKED_QUAD;
+        for (unsigned h = 0; h < 27; ++h) {
+            bitfield digits[9];
+            unsigned row, col;
+            for (unsigned m = 0; m < 9; ++m) {
+                _house_cell(h, m, row, col);
+                digits[m] = matrix[row][col] ? 0 : memory[row][col];
             }
+            auto found = [this, h, t, &digits](unsigned chosen, bitfield cover) {
+                unsigned row, col;
+                for (unsigned m = 0; m < 9; ++m) {
+                    _house_cell(h, m, row, col);
+                    if (!(chosen & 1u << m) && digits[m])
+                        _eliminate(row, col, cover, t);
+                }
+            };
+            _subsets<N>(digits, 9, found);
         }
-        return false;
     }
+    // Where each digit still fits in each house: bit m of places[h][num - 1]
+    // is cell m of house h
+    void _places(bitfield places[27][9]) {
+        std::memset(places, 0, 27 * sizeof *places);
+        for (unsigned row = 0; row < 9; ++row)
+            for (unsigned col = 0; col < 9; ++col) {
+                if (matrix[row][col])
+                    continue;
+                unsigned block = 18 + row / 3 * 3 + col / 3;
+                for (bitfield rest = memory[row][col]; rest; rest &= rest - 1) {
+                    unsigned d = numFor(rest & (0 - rest)) - 1;
+                    places[row][d] |= 1u << col;
+                    places[9 + col][d] |= 1u << row;
+                    places[block][d] |= 1u << (row % 3 * 3 + col % 3);
+                }
+            }
+    }
+    // N digits that fit only N cells of a house between them leave no room
+    // for other digits in those cells
+    template <unsigned N>
+    void _hidden_subsets() {
+        const technique t = N == 2 ? HIDDEN_PAIR : HIDDEN_TRIPLE;
+        bitfield places[27][9];
+        _places(places);
+        for (unsigned h = 0; h < 27; ++h) {
+            auto found = [this, h, t](unsigned chosen, bitfield cover) {
+                unsigned row, col;
+                for (unsigned m = 0; m < 9; ++m)
+                    if (cover & 1u << m) {
+                        _house_cell(h, m, row, col);
+                        _eliminate(row, col, allSet & ~chosen, t);
+                    }
+            };
+            _subsets<N>(places[h], 9, found);
+        }
+    }
+    // X-Wing (N = 2) and Swordfish (N = 3): when a digit fits N rows only
+    // in the same N columns, it leaves those columns' other rows, and the
+    // same with rows and columns swapped
+    template <unsigned N>
+    void _fish() {
+        const technique t = N == 2 ? X_WING : SWORDFISH;
+        bitfield places[27][9];
+        _places(places);
+        for (unsigned d = 0; d < 9; ++d)
+            for (unsigned by_col = 0; by_col < 2; ++by_col) {
+                bitfield lines[9];
+                unsigned count = 0;
+                for (unsigned line = 0; line < 9; ++line) {
+                    lines[line] = places[9 * by_col + line][d];
+                    // A line that fits the digit once is a hidden single
+                    if (bitCount(lines[line]) < 2)
+                        lines[line] = 0;
+                    else
+                        ++count;
+                }
+                if (count <= N)
+                    continue;
+                auto found = [this, by_col, d, t](unsigned chosen, bitfield cover) {
+                    for (unsigned line = 0; line < 9; ++line) {
+                        if (chosen & 1u << line)
+                            continue;
+                        for (unsigned cross = 0; cross < 9; ++cross) {
+                            unsigned row = by_col ? cross : line, col = by_col ? line : cross;
+                            if ((cover & 1u << cross) && !matrix[row][col])
+                                _eliminate(row, col, bitFor(d + 1), t);
+                        }
+                    }
+                };
+                _subsets<N>(lines, 9, found);
+            }
+    }
+    // A pivot with candidates {x, y} that sees a cell with {x, z} and a cell
+    // with {y, z}: one of the two pincers is z, so z leaves every cell that
+    // sees both
+    void _xy_wing() {
+        unsigned char pairs[81];
+        unsigned count = 0;
+        for (unsigned cell = 0; cell < 81; ++cell)
+            if (!matrix[cell / 9][cell % 9] && bitCount(memory[cell / 9][cell % 9]) == 2)
+                pairs[count++] = static_cast<unsigned char>(cell);
+        for (unsigned p = 0; p < count; ++p) {
+            bitfield pivot = memory[pairs[p] / 9][pairs[p] % 9];
+            // The cells the pivot sees that share exactly one digit with it
+            unsigned char pincers[81];
+            unsigned found = 0;
+            for (unsigned a = 0; a < count; ++a) {
+                bitfield digits = memory[pairs[a] / 9][pairs[a] % 9];
+                if (a != p && bitCount(digits & pivot) == 1 && _sees(pairs[p], pairs[a]))
+                    pincers[found++] = pairs[a];
+            }
+            for (unsigned a = 0; a < found; ++a) {
+                bitfield first = memory[pincers[a] / 9][pincers[a] % 9];
+                bitfield z = first & ~pivot;
+                bitfield second = (pivot & ~first) | z;
+                for (unsigned b = a + 1; b < found; ++b) {
+                    if (memory[pincers[b] / 9][pincers[b] % 9] != second)
+                        continue;
+                    for (unsigned cell = 0; cell < 81; ++cell)
+                        if (cell != pincers[a] && cell != pincers[b] &&
+                                !matrix[cell / 9][cell % 9] && (memory[cell / 9][cell % 9] & z) &&
+                                _sees(cell, pincers[a]) && _sees(cell, pincers[b]))
+                            _eliminate(cell / 9, cell % 9, z, XY_WING);
+                }
+            }
+        }
+    }
+    // Bit mask of the three houses holding a cell
+    static unsigned _houses_of(unsigned row, unsigned col) {
+        return 1u << row | 1u << (9 + col) | 1u << (18 + row / 3 * 3 + col / 3);
+    }
+    void _enlist(unsigned row, unsigned col) {
+        std::memmove(_open_cells + 1, _open_cells, _open_count++);
+        _open_cells[0] = static_cast<unsigned char>(9 * row + col);
+    }
+    // Fills the empty board with a random complete grid. The three
+    // diagonal blocks share no row or column, so any permutation of 1-9
+    // fits each of them; the rest is completed by an MRV search that tries
+    // the candidates of every cell in random order. The search is complete
+    // and the grid always has a completion, so this never fails. The
+    // hidden-single check that backtrack() prunes with does not pay for
+    // itself on a grid this open.
+    void _random_fill(Random & rng) {
+        for (unsigned b = 0; b < 9; b += 4) {
+            unsigned digits[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+            for (unsigned k = 8; k > 0; --k) {
+                unsigned other = rng.below(k + 1);
+                unsigned swap = digits[k];
+                digits[k] = digits[other];
+                digits[other] = swap;
+            }
+            for (unsigned k = 0; k < 9; ++k)
+                set(b / 3 * 3 + k / 3, b % 3 * 3 + k % 3, digits[k]);
+        }
+        _open_count = 0;
+        for (unsigned i = 0; i < 9; ++i)
+            for (unsigned j = 0; j < 9; ++j)
+                if (!matrix[i][j])
+                    _open_cells[_open_count++] = static_cast<unsigned char>(9 * i + j);
+        _random_search(rng);
+    }
+    bool _random_search(Random & rng) {
+        unsigned row, col;
+        bool unique = false;
+        if (!_open_count)
+            return true;
+        if (!findMin(row, col, unique))
+            return false;
 
-    void _random_fill() {
-        for (unsigned i = 1; i <= 5; ++i)
-            _fill(false, 0, i);
-        if (!_fill(true, 0, 6))
-            std::cout << "Error" << std::endl;
+        bitfield possible = mask_check(row, col, allSet);
+        while (possible) {
+            // Drop a uniformly chosen number of low bits to pick a candidate
+            bitfield mask = possible;
+            for (unsigned skip = rng.below(bitCount(possible)); skip; --skip)
+                mask &= mask - 1;
+            mask &= 0 - mask;
+            possible &= ~mask;
+            _set<false>(row, col, numFor(mask));
+            if (_random_search(rng))
+                return true;
+            unset(row, col);
+        }
+        _enlist(row, col);
+        return false;
     }
 };
 
+static_assert(std::is_trivially_copyable<Board>::value,
+              "Board must stay copyable with memcpy");
+
 #endif
 
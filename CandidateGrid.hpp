@@ -0,0 +1,58 @@
+#ifndef CANDIDATE_GRID_H
+#define CANDIDATE_GRID_H
+
+#include "Bits.hpp"
+#include "Simd.hpp"
+
+// The candidates of all 81 cells together with the hidden-single masks of
+// every house: the digits that are a candidate of exactly one open cell in
+// that row, column or block. Rows are 16 lanes wide; lanes 9-15 are zero.
+struct CandidateGrid {
+    lane_t cells[9][16];
+    lane_t row_single[9], col_single[9], block_single[9];
+
+    // rows, cols and blocks are the digits each house still misses (cols
+    // padded to 16 lanes with zeros, blocks numbered 3 * (i / 3) + j / 3).
+    // open[i][j] limits the cell's candidates and is 0 for filled cells.
+    void compute(const lane_t rows[9], const lane_t cols[16],
+                 const lane_t blocks[9], const lane_t open[9][16]) {
+        lane_t lanes[16];
+        Lanes16 col_mask = Lanes16::load(cols);
+        Tally columns = Tally::of(Lanes16::zero());
+        for (unsigned band = 0; band < 3; ++band) {
+            for (unsigned k = 0; k < 16; ++k)
+                lanes[k] = k < 9 ? blocks[3 * band + k / 3] : 0;
+            Lanes16 band_mask = col_mask & Lanes16::load(lanes);
+            Tally blocks_tally = Tally::of(Lanes16::zero());
+            for (unsigned i = 3 * band; i < 3 * band + 3; ++i) {
+                Lanes16 cell = Lanes16::all(rows[i]) & band_mask & Lanes16::load(open[i]);
+                cell.store(cells[i]);
+                Tally t = Tally::of(cell);
+                columns.add(t);
+                blocks_tally.add(t);
+
+                // Fold the row's lanes into lane 0
+                t.add(t.shift<8>());
+                t.add(t.shift<4>());
+                t.add(t.shift<2>());
+                t.add(t.shift<1>());
+                t.single().store(lanes);
+                row_single[i] = lanes[0];
+            }
+
+            // Fold each block's three columns into its first lane
+            Tally next = blocks_tally.shift<1>();
+            Tally after = blocks_tally.shift<2>();
+            blocks_tally.add(next);
+            blocks_tally.add(after);
+            blocks_tally.single().store(lanes);
+            for (unsigned k = 0; k < 3; ++k)
+                block_single[3 * band + k] = lanes[3 * k];
+        }
+        columns.single().store(lanes);
+        for (unsigned j = 0; j < 9; ++j)
+            col_single[j] = lanes[j];
+    }
+};
+
+#endif
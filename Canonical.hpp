@@ -0,0 +1,271 @@
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+#include <algorithm>
+#include <cstdint>
+
+// A symmetry of the grid: an optional transposition, then a reordering of
+// rows and columns that keeps bands and stacks whole, then a relabeling of
+// the digits. Canonical cell (i, j) comes from row rows[i] and column
+// cols[j] of the (transposed) source, with its digit d becoming digits[d].
+struct Transform {
+    bool transpose;
+    unsigned char rows[9], cols[9];
+    unsigned char digits[10];
+
+    // `out` must not be `in`
+    void apply(const unsigned char in[81], unsigned char out[81]) const {
+        for (unsigned k = 0; k < 81; ++k)
+            out[k] = digits[in[_source(k)]];
+    }
+    // Takes a canonical grid, such as the solution of the canonical puzzle,
+    // back to the source's coordinates and digits. `out` must not be `in`.
+    void revert(const unsigned char in[81], unsigned char out[81]) const {
+        unsigned char back[10];
+        for (unsigned d = 0; d < 10; ++d)
+            back[digits[d]] = static_cast<unsigned char>(d);
+        for (unsigned k = 0; k < 81; ++k)
+            out[_source(k)] = back[in[k]];
+    }
+private:
+    unsigned _source(unsigned k) const {
+        unsigned r = rows[k / 9], c = cols[k % 9];
+        return transpose ? 9 * c + r : 9 * r + c;
+    }
+};
+
+// Finds a canonical form of a puzzle: the smallest 81-cell string, blanks
+// first and digits relabeled in order of appearance, over the symmetries
+// that order bands, rows, stacks and columns by keys no symmetry changes.
+// A row's key is the multiset of (how often its digit appears, how many
+// givens its column has) over its givens, a band's the sorted keys of its
+// rows, and columns and stacks the same way round. Only the orders that
+// tie on those keys are tried, so equivalent puzzles meet in the same form
+// as long as the ties stay within `budget` orders. Past that the form is
+// still the puzzle under a valid transform, just not always the same one.
+class Canonicalizer {
+public:
+    static const unsigned budget = 64;
+
+    // Returns false if the ties went past the budget
+    bool run(const unsigned char cells[81], unsigned char canon[81], Transform & t) {
+        _keys(cells);
+        Orientation sides[2];
+        for (unsigned o = 0; o < 2; ++o)
+            _order(sides[o], cells, o != 0);
+        int side = _compare(sides[0], sides[1]);
+        unsigned long orders = 0;
+        for (unsigned o = 0; o < 2; ++o)
+            if (side == 0 || (side < 0) == (o == 0))
+                orders += sides[o].orders;
+        _found = false;
+        _left = budget;
+        for (unsigned o = 0; o < 2; ++o)
+            if (side == 0 || (side < 0) == (o == 0))
+                _search(sides[o]);
+        std::copy(_best, _best + 81, canon);
+        t = _transform;
+        _relabel(t);
+        return orders <= budget;
+    }
+private:
+    struct Segment {
+        unsigned char * first;
+        unsigned length;
+    };
+    struct Orientation {
+        bool transpose;
+        unsigned char grid[9][9];
+        std::uint64_t band_keys[3][3], stack_keys[3][3];
+        unsigned char bands[3], band_rows[3][3];
+        unsigned char stacks[3], stack_cols[3][3];
+        // The runs of the orders above that tie on their keys
+        Segment ties[16];
+        unsigned tie_count;
+        unsigned long orders;
+    };
+
+    std::uint64_t _row_keys[9], _col_keys[9];
+    unsigned char _best[81];
+    Transform _transform;
+    bool _found;
+    unsigned _left;
+
+    void _keys(const unsigned char cells[81]) {
+        unsigned freq[10] = { 0 }, row_count[9] = { 0 }, col_count[9] = { 0 };
+        for (unsigned k = 0; k < 81; ++k)
+            if (cells[k]) {
+                ++freq[cells[k]];
+                ++row_count[k / 9];
+                ++col_count[k % 9];
+            }
+        for (unsigned line = 0; line < 9; ++line) {
+            unsigned row[9], col[9], rows = 0, cols = 0;
+            for (unsigned m = 0; m < 9; ++m) {
+                unsigned in_row = cells[9 * line + m], in_col = cells[9 * m + line];
+                if (in_row)
+                    row[rows++] = 10 * freq[in_row] + col_count[m];
+                if (in_col)
+                    col[cols++] = 10 * freq[in_col] + row_count[m];
+            }
+            _row_keys[line] = _pack(row, rows);
+            _col_keys[line] = _pack(col, cols);
+        }
+    }
+    // Up to nine values under 100, largest first, in seven bits each
+    static std::uint64_t _pack(unsigned values[9], unsigned count) {
+        for (unsigned k = 1; k < count; ++k)
+            for (unsigned m = k; m > 0 && values[m] < values[m - 1]; --m)
+                std::swap(values[m], values[m - 1]);
+        std::uint64_t key = 0;
+        for (unsigned k = count; k-- > 0;)
+            key = key << 7 | values[k];
+        return key << 7 * (9 - count);
+    }
+    void _order(Orientation & side, const unsigned char cells[81], bool transpose) {
+        side.transpose = transpose;
+        for (unsigned r = 0; r < 9; ++r)
+            for (unsigned c = 0; c < 9; ++c)
+                side.grid[r][c] = transpose ? cells[9 * c + r] : cells[9 * r + c];
+        const std::uint64_t * row_keys = transpose ? _col_keys : _row_keys;
+        const std::uint64_t * col_keys = transpose ? _row_keys : _col_keys;
+        side.tie_count = 0;
+        side.orders = 1;
+        _order_lines(side, row_keys, side.band_keys, side.bands, side.band_rows);
+        _order_lines(side, col_keys, side.stack_keys, side.stacks, side.stack_cols);
+    }
+    // Sorts the lines of each band by key, then the bands by their sorted
+    // keys, recording the runs that tie
+    void _order_lines(Orientation & side, const std::uint64_t keys[9],
+                      std::uint64_t band_keys[3][3], unsigned char bands[3],
+                      unsigned char lines[3][3]) {
+        for (unsigned b = 0; b < 3; ++b) {
+            for (unsigned k = 0; k < 3; ++k)
+                lines[b][k] = static_cast<unsigned char>(3 * b + k);
+            _sort(lines[b], [keys](unsigned line) { return keys[line]; });
+            for (unsigned k = 0; k < 3; ++k)
+                band_keys[b][k] = keys[lines[b][k]];
+            bands[b] = static_cast<unsigned char>(b);
+        }
+        unsigned order[3] = { 0, 1, 2 };
+        std::stable_sort(order, order + 3, [band_keys](unsigned a, unsigned b) {
+            return std::lexicographical_compare(band_keys[a], band_keys[a] + 3,
+                                                band_keys[b], band_keys[b] + 3);
+        });
+        for (unsigned k = 0; k < 3; ++k)
+            bands[k] = static_cast<unsigned char>(order[k]);
+        _ties(side, bands, [band_keys](unsigned b) { return _triple(band_keys[b]); });
+        for (unsigned b = 0; b < 3; ++b)
+            _ties(side, lines[b], [keys](unsigned line) { return keys[line]; });
+    }
+    struct Triple {
+        std::uint64_t keys[3];
+        bool operator==(const Triple & other) const {
+            return keys[0] == other.keys[0] && keys[1] == other.keys[1] &&
+                   keys[2] == other.keys[2];
+        }
+    };
+    static Triple _triple(const std::uint64_t keys[3]) {
+        Triple t = { { keys[0], keys[1], keys[2] } };
+        return t;
+    }
+    // Stable insertion sort of three items by key
+    template <class Key>
+    static void _sort(unsigned char items[3], Key key) {
+        for (unsigned k = 1; k < 3; ++k)
+            for (unsigned m = k; m > 0 && key(items[m]) < key(items[m - 1]); --m)
+                std::swap(items[m], items[m - 1]);
+    }
+    template <class Key>
+    static void _ties(Orientation & side, unsigned char items[3], Key key) {
+        for (unsigned k = 0; k < 3;) {
+            unsigned end = k + 1;
+            while (end < 3 && key(items[end]) == key(items[k]))
+                ++end;
+            if (end - k > 1) {
+                side.ties[side.tie_count].first = items + k;
+                side.ties[side.tie_count++].length = end - k;
+                side.orders *= end - k == 2 ? 2 : 6;
+            }
+            k = end;
+        }
+    }
+    // Orders the two orientations by their sorted band and stack keys
+    static int _compare(const Orientation & a, const Orientation & b) {
+        for (unsigned k = 0; k < 3; ++k)
+            for (unsigned m = 0; m < 3; ++m) {
+                std::uint64_t x = a.band_keys[a.bands[k]][m], y = b.band_keys[b.bands[k]][m];
+                if (x != y)
+                    return x < y ? -1 : 1;
+            }
+        for (unsigned k = 0; k < 3; ++k)
+            for (unsigned m = 0; m < 3; ++m) {
+                std::uint64_t x = a.stack_keys[a.stacks[k]][m], y = b.stack_keys[b.stacks[k]][m];
+                if (x != y)
+                    return x < y ? -1 : 1;
+            }
+        return 0;
+    }
+    // Tries every order of the tied runs, as an odometer over their
+    // permutations, until the orders or the budget run out
+    void _search(Orientation & side) {
+        do {
+            if (!_left)
+                return;
+            --_left;
+            _try(side);
+        } while (_advance(side));
+    }
+    static bool _advance(Orientation & side) {
+        for (unsigned k = 0; k < side.tie_count; ++k) {
+            Segment & s = side.ties[k];
+            if (std::next_permutation(s.first, s.first + s.length))
+                return true;
+        }
+        return false;
+    }
+    void _try(const Orientation & side) {
+        unsigned char rows[9], cols[9], map[10] = { 0 }, form[81];
+        for (unsigned k = 0; k < 9; ++k) {
+            rows[k] = side.band_rows[side.bands[k / 3]][k % 3];
+            cols[k] = side.stack_cols[side.stacks[k / 3]][k % 3];
+        }
+        unsigned next = 1;
+        bool smaller = !_found;
+        for (unsigned k = 0; k < 81; ++k) {
+            unsigned v = side.grid[rows[k / 9]][cols[k % 9]];
+            if (v) {
+                if (!map[v])
+                    map[v] = static_cast<unsigned char>(next++);
+                v = map[v];
+            }
+            if (!smaller) {
+                if (v > _best[k])
+                    return;
+                smaller = v < _best[k];
+            }
+            form[k] = static_cast<unsigned char>(v);
+        }
+        if (!smaller)
+            return;
+        std::copy(form, form + 81, _best);
+        _transform.transpose = side.transpose;
+        std::copy(rows, rows + 9, _transform.rows);
+        std::copy(cols, cols + 9, _transform.cols);
+        std::copy(map, map + 10, _transform.digits);
+        _found = true;
+    }
+    // Digits in order of appearance, then the digits the puzzle lacks in
+    // ascending order
+    static void _relabel(Transform & t) {
+        unsigned next = 1;
+        for (unsigned d = 1; d < 10; ++d)
+            if (t.digits[d])
+                ++next;
+        for (unsigned d = 1; d < 10; ++d)
+            if (!t.digits[d])
+                t.digits[d] = static_cast<unsigned char>(next++);
+    }
+};
+
+#endif
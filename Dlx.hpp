@@ -0,0 +1,158 @@
+#ifndef DLX_H
+#define DLX_H
+
+#include "Board.hpp"
+
+// Solves a board as an exact-cover problem with Knuth's Algorithm X on
+// dancing links. Each candidate placement is a row covering four of the 324
+// constraints (cell filled, digit in row, in column and in block); givens
+// are applied up front by dropping the constraints they satisfy. All links
+// live in fixed arrays that are rebuilt for every board.
+class DancingLinks {
+public:
+    unsigned long nodes;
+
+    DancingLinks()
+        : nodes(0) {
+    }
+    // Returns the number of solutions found, stopping at `limit`, and
+    // writes the first one into `board`. Clashing givens count as no
+    // solution.
+    unsigned solve(Board & board, unsigned limit = 1) {
+        nodes = 0;
+        _solutions = 0;
+        _limit = limit ? limit : 1;
+        if (!_build(board))
+            return 0;
+        _search(0);
+        if (_solutions)
+            for (unsigned k = 0; k < _answer_size; ++k) {
+                unsigned row = _answer[k];
+                board.set(row / 81, row / 9 % 9, row % 9 + 1);
+            }
+        return _solutions;
+    }
+private:
+    static const unsigned columns = 324;
+    static const unsigned capacity = 1 + columns + 4 * 729;
+
+    unsigned short _left[capacity], _right[capacity], _up[capacity], _down[capacity];
+    unsigned short _col[capacity], _row[capacity];
+    unsigned short _size[1 + columns];
+    unsigned short _stack[81], _answer[81];
+    unsigned _answer_size, _solutions, _limit;
+
+    // Header index (1-based) of the four constraints placing num at (i, j)
+    static void _constraints(unsigned i, unsigned j, unsigned num, unsigned out[4]) {
+        unsigned d = num - 1;
+        out[0] = 1 + 9 * i + j;
+        out[1] = 1 + 81 + 9 * i + d;
+        out[2] = 1 + 162 + 9 * j + d;
+        out[3] = 1 + 243 + 9 * (i / 3 * 3 + j / 3) + d;
+    }
+    bool _build(Board & board) {
+        bool satisfied[1 + columns] = { false };
+        unsigned ids[4];
+        for (unsigned i = 0; i < 9; ++i)
+            for (unsigned j = 0; j < 9; ++j)
+                if (unsigned num = board.get_num(i, j)) {
+                    _constraints(i, j, num, ids);
+                    for (unsigned k = 0; k < 4; ++k) {
+                        if (satisfied[ids[k]])
+                            return false;
+                        satisfied[ids[k]] = true;
+                    }
+                }
+
+        unsigned last = 0;
+        for (unsigned c = 1; c <= columns; ++c) {
+            _up[c] = _down[c] = static_cast<unsigned short>(c);
+            _size[c] = 0;
+            if (satisfied[c])
+                continue;
+            _right[last] = static_cast<unsigned short>(c);
+            _left[c] = static_cast<unsigned short>(last);
+            last = c;
+        }
+        _right[last] = 0;
+        _left[0] = static_cast<unsigned short>(last);
+
+        unsigned node = 1 + columns;
+        for (unsigned i = 0; i < 9; ++i)
+            for (unsigned j = 0; j < 9; ++j) {
+                if (board.get_num(i, j))
+                    continue;
+                for (unsigned num = 1; num <= 9; ++num) {
+                    _constraints(i, j, num, ids);
+                    if (satisfied[ids[1]] || satisfied[ids[2]] || satisfied[ids[3]])
+                        continue;
+                    unsigned first = node;
+                    for (unsigned k = 0; k < 4; ++k, ++node) {
+                        unsigned c = ids[k];
+                        _col[node] = static_cast<unsigned short>(c);
+                        _row[node] = static_cast<unsigned short>(81 * i + 9 * j + num - 1);
+                        _up[node] = _up[c];
+                        _down[node] = static_cast<unsigned short>(c);
+                        _down[_up[c]] = static_cast<unsigned short>(node);
+                        _up[c] = static_cast<unsigned short>(node);
+                        ++_size[c];
+                        _left[node] = static_cast<unsigned short>(k ? node - 1 : first + 3);
+                        _right[node] = static_cast<unsigned short>(k < 3 ? node + 1 : first);
+                    }
+                }
+            }
+        return true;
+    }
+    void _cover(unsigned c) {
+        _right[_left[c]] = _right[c];
+        _left[_right[c]] = _left[c];
+        for (unsigned i = _down[c]; i != c; i = _down[i])
+            for (unsigned j = _right[i]; j != i; j = _right[j]) {
+                _down[_up[j]] = _down[j];
+                _up[_down[j]] = _up[j];
+                --_size[_col[j]];
+            }
+    }
+    void _uncover(unsigned c) {
+        for (unsigned i = _up[c]; i != c; i = _up[i])
+            for (unsigned j = _left[i]; j != i; j = _left[j]) {
+                ++_size[_col[j]];
+                _down[_up[j]] = static_cast<unsigned short>(j);
+                _up[_down[j]] = static_cast<unsigned short>(j);
+            }
+        _right[_left[c]] = static_cast<unsigned short>(c);
+        _left[_right[c]] = static_cast<unsigned short>(c);
+    }
+    void _search(unsigned depth) {
+        if (_right[0] == 0) {
+            if (++_solutions == 1) {
+                for (unsigned k = 0; k < depth; ++k)
+                    _answer[k] = _stack[k];
+                _answer_size = depth;
+            }
+            return;
+        }
+
+        // Branch on the constraint with the fewest candidates
+        unsigned chosen = _right[0];
+        for (unsigned c = _right[chosen]; c != 0 && _size[chosen] > 1; c = _right[c])
+            if (_size[c] < _size[chosen])
+                chosen = c;
+        if (!_size[chosen])
+            return;
+
+        _cover(chosen);
+        for (unsigned r = _down[chosen]; r != chosen && _solutions < _limit; r = _down[r]) {
+            ++nodes;
+            _stack[depth] = _row[r];
+            for (unsigned j = _right[r]; j != r; j = _right[j])
+                _cover(_col[j]);
+            _search(depth + 1);
+            for (unsigned j = _left[r]; j != r; j = _left[j])
+                _uncover(_col[j]);
+        }
+        _uncover(chosen);
+    }
+};
+
+#endif
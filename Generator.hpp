@@ -0,0 +1,119 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <algorithm>
+#include <memory>
+
+#include "Holes.hpp"
+#include "PuzzleIO.hpp"
+#include "ThreadPool.hpp"
+
+// The generator for puzzle `index` of `level` in a run seeded with `seed`.
+// Any single puzzle can be regenerated from these three numbers.
+static inline Random puzzle_random(std::uint64_t seed, difficulty level, unsigned long index) {
+    return Random(seed, static_cast<std::uint64_t>(index) << 3 | level);
+}
+
+static inline const char * difficulty_name(difficulty level) {
+    static const char * names[] = { "default", "easy", "medium", "difficult", "evil" };
+    return names[level];
+}
+
+// Generates puzzles with indices [first, first + count) of one level and
+// writes them to `out` as one 81-character line each ('.' for blanks), in
+// index order. Work is split into chunks; with more than one thread they
+// are generated on a work-stealing pool while a bounded window of chunks
+// is in flight. The output depends only on the seed, never on the thread
+// count.
+class BatchGenerator {
+public:
+    static const unsigned chunk_size = 16;
+
+    BatchGenerator(std::FILE * out, std::uint64_t seed, unsigned threads = 1)
+        : _writer(out), _seed(seed), _threads(threads ? threads : 1) {
+    }
+    void run(difficulty level, unsigned long first, unsigned long count) {
+        _level = level;
+        _first = first;
+        _end = first + count;
+        if (_threads == 1) {
+            std::unique_ptr<Chunk> chunk(new Chunk);
+            for (unsigned long next = first; next < _end; next += chunk_size) {
+                chunk->first = next;
+                _generate(*chunk);
+                _write(*chunk);
+            }
+        } else {
+            _run_parallel();
+        }
+        _writer.flush();
+    }
+private:
+    struct Chunk {
+        unsigned long first;
+        unsigned count;
+        bool done;
+        char lines[chunk_size][82];
+    };
+
+    OutputBuffer _writer;
+    std::uint64_t _seed;
+    unsigned _threads;
+    difficulty _level;
+    unsigned long _first, _end;
+    std::mutex _done_lock;
+    std::condition_variable _done;
+
+    void _generate(Chunk & chunk) {
+        chunk.count = static_cast<unsigned>(std::min<unsigned long>(chunk_size, _end - chunk.first));
+        Board puzzle, answer;
+        for (unsigned k = 0; k < chunk.count; ++k) {
+            Random rng = puzzle_random(_seed, _level, chunk.first + k);
+            generate_puzzle(_level, rng, puzzle, answer);
+            unsigned char cells[81];
+            for (unsigned c = 0; c < 81; ++c)
+                cells[c] = static_cast<unsigned char>(puzzle.get_num(c / 9, c % 9));
+            format_line(cells, chunk.lines[k]);
+        }
+    }
+    void _write(Chunk & chunk) {
+        for (unsigned k = 0; k < chunk.count; ++k)
+            _writer.write(chunk.lines[k], 82);
+    }
+    void _finish(Chunk & chunk) {
+        std::lock_guard<std::mutex> guard(_done_lock);
+        chunk.done = true;
+        _done.notify_all();
+    }
+    void _wait(Chunk & chunk) {
+        std::unique_lock<std::mutex> guard(_done_lock);
+        _done.wait(guard, [&chunk] { return chunk.done; });
+    }
+    void _run_parallel() {
+        unsigned window = 4 * _threads;
+        std::vector<Chunk> slots(window);
+        ThreadPool pool(_threads);
+        unsigned long issued = 0, written = 0;
+        for (unsigned long next = _first; next < _end; next += chunk_size) {
+            if (issued - written == window) {
+                Chunk & oldest = slots[written++ % window];
+                _wait(oldest);
+                _write(oldest);
+            }
+            Chunk & chunk = slots[issued++ % window];
+            chunk.first = next;
+            chunk.done = false;
+            pool.submit([this, &chunk] {
+                _generate(chunk);
+                _finish(chunk);
+            });
+        }
+        while (written < issued) {
+            Chunk & oldest = slots[written++ % window];
+            _wait(oldest);
+            _write(oldest);
+        }
+    }
+};
+
+#endif
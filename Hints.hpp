@@ -0,0 +1,157 @@
+#ifndef HINTS_H
+#define HINTS_H
+
+#include <cstring>
+#include <ostream>
+
+#include "Board.hpp"
+
+// One step towards the solution. `techniques` has bit t set for the single
+// that placed it and for every technique whose eliminations touched its
+// houses; a revealed step is copied from the answer because no rule
+// applies.
+struct Hint {
+    unsigned row, col, val;
+    unsigned techniques;
+    bool revealed;
+
+    // Room format needs: the longest cell, every technique name and the
+    // separators between them
+    static const unsigned text_capacity = 256;
+
+    void print(std::ostream & out) const {
+        char text[text_capacity];
+        out.write(text, format(text));
+    }
+    // Writes what print shows into `text` without a terminator and returns
+    // its length
+    unsigned format(char * text) const {
+        unsigned length = 0;
+        text[length++] = 'R';
+        text[length++] = static_cast<char>('1' + row);
+        text[length++] = 'C';
+        text[length++] = static_cast<char>('1' + col);
+        text[length++] = '=';
+        text[length++] = static_cast<char>('0' + val);
+        if (revealed)
+            return _append(text, length, " (revealed: no technique applies)");
+        length = _append(text, length, " by ");
+        length = _append(text, length, technique_name(techniques & 1u << NAKED_SINGLE ? NAKED_SINGLE
+                                                                                      : HIDDEN_SINGLE));
+        const char * separator = " after ";
+        for (unsigned t = LOCKED_SET; t < technique_count; ++t)
+            if (techniques & 1u << t) {
+                length = _append(text, length, separator);
+                length = _append(text, length, technique_name(static_cast<technique>(t)));
+                separator = ", ";
+            }
+        return length;
+    }
+private:
+    static unsigned _append(char * text, unsigned length, const char * what) {
+        unsigned size = static_cast<unsigned>(std::strlen(what));
+        std::memcpy(text + length, what, size);
+        return length + size;
+    }
+};
+
+// Hints for one game, kept across moves. The engine's board is the
+// player's board plus every step it has derived, with its candidates
+// narrowed by every elimination so far; since the solution is unique and
+// every move is checked against it, none of that goes stale. A hint is the
+// oldest derived step the player has not filled yet, so asking twice gives
+// the same answer at no cost, and a new step resumes the rules where the
+// last one stopped instead of starting over from the player's board.
+class HintEngine {
+public:
+    HintEngine()
+        : _started(false) {
+    }
+    bool started() const {
+        return _started;
+    }
+    // `answer` must be the unique solution of `board`
+    void start(const Board & board, const Board & answer) {
+        _logic = board;
+        _answer = answer;
+        _logic.start_steps();
+        for (unsigned k = 0; k < 81; ++k)
+            _filled[k] = _logic.get_num(k / 9, k % 9) != 0;
+        _count = _first = 0;
+        _started = true;
+    }
+    // A correct move by the player
+    void play(unsigned row, unsigned col, unsigned val) {
+        _filled[9 * row + col] = 1;
+        if (!_logic.get_num(row, col))
+            _logic.set(row, col, val, true);
+    }
+    // The next step, or false once the board is complete
+    bool next(Hint & hint) {
+        while (_first < _count && _filled[_steps[_first].row * 9 + _steps[_first].col])
+            ++_first;
+        if (_first == _count && !_derive())
+            return false;
+        hint = _steps[_first];
+        return true;
+    }
+private:
+    Board _logic;
+    Board _answer;
+    // Derived steps in order; those before _first are filled
+    Hint _steps[81];
+    unsigned _count, _first;
+    // What the last advanced_step did
+    StepLog _log;
+    unsigned char _filled[81];
+    bool _started;
+
+    // Queues the next batch of steps: every single one pass of the rules
+    // shows, or a revealed cell when none does
+    bool _derive() {
+        if (!_logic.remaining())
+            return false;
+        _logic.log_steps_to(&_log);
+        bool found = _logic.advanced_step();
+        _logic.log_steps_to(0);
+        if (!found) {
+            Hint & step = _steps[_count++];
+            _reveal(step.row, step.col);
+            step.val = _answer.get_num(step.row, step.col);
+            step.techniques = 0;
+            step.revealed = true;
+            _logic.set(step.row, step.col, step.val, true);
+            return true;
+        }
+        // Each placement names the single that made it and the
+        // eliminations in its own houses
+        for (unsigned i = 0; i < 9; ++i)
+            for (unsigned j = 0; j < 9; ++j) {
+                if (!_log.placed(i, j))
+                    continue;
+                Hint & step = _steps[_count++];
+                step.row = i, step.col = j;
+                step.val = _logic.get_num(i, j);
+                step.techniques = _log.techniques(i, j);
+                step.revealed = false;
+            }
+        return true;
+    }
+    // The open cell with the fewest candidates left, the one the player is
+    // nearest to working out
+    void _reveal(unsigned & row, unsigned & col) {
+        unsigned fewest = 10;
+        for (unsigned i = 0; i < 9; ++i)
+            for (unsigned j = 0; j < 9; ++j) {
+                if (_logic.get_num(i, j))
+                    continue;
+                unsigned count = bitCount(_logic.mask_check(i, j, allSet));
+                if (count < fewest) {
+                    fewest = count;
+                    row = i, col = j;
+                }
+            }
+    }
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef HOLES_H
+#define HOLES_H
+
+#include "Board.hpp"
+
+enum difficulty { DEFAULT, EASY, MEDIUM, DIFFICULT, EVIL };
+
+// How a puzzle is solved by logic: cells placed by singles, cells placed by
+// the advanced rules after them, and cells still open for search.
+struct Rating {
+    // Puzzles leaving at least this many cells to search are EVIL
+    static const unsigned evil_search = 40;
+
+    unsigned singles, advanced, search;
+
+    difficulty level() const {
+        if (search >= evil_search)
+            return EVIL;
+        if (search)
+            return DIFFICULT;
+        if (advanced)
+            return MEDIUM;
+        return EASY;
+    }
+};
+
+// Rates `board` and leaves it where logic stops
+static inline Rating rate_in_place(Board & board) {
+    Rating rating;
+    unsigned open = board.remaining();
+    board.hidden_fill();
+    rating.singles = open - board.remaining();
+    open = board.remaining();
+    if (open)
+        board.advanced_fill();
+    rating.advanced = open - board.remaining();
+    rating.search = board.remaining();
+    return rating;
+}
+
+static inline Rating rate_puzzle(Board board) {
+    return rate_in_place(board);
+}
+
+// Digs holes into a complete grid, visiting cells in a given order. A hole
+// is kept while the solution stays unique and the rating stays at or below
+// the chosen level: solvable by hidden singles alone for EASY, no cap for
+// DEFAULT. Removing a clue never makes a puzzle easier, so the rating is
+// carried from dig to dig and only checked against the cap. All randomness
+// comes from the Random passed in.
+class Holes {
+public:
+    // Where digging can be rolled back to
+    struct Mark {
+        TrailMark board;
+        difficulty level;
+    };
+
+    Holes(Board & board, Random & rng)
+        : puzzle(board), _rng(rng), _level(EASY) {
+        puzzle.trail_to(&_trail);
+    }
+    // The board logs to this object's trail, so it is not copied
+    Holes(const Holes &) = delete;
+    Holes & operator=(const Holes &) = delete;
+    // Digs every cell, in a fresh random order
+    void digHoles(difficulty level) {
+        unsigned order[81];
+        for (unsigned c = 0; c < 81; ++c)
+            order[c] = c;
+        shuffle(order, 81);
+        digHoles(level, order, 81);
+    }
+    void digHoles(difficulty level, const unsigned * order, unsigned count) {
+        for (unsigned k = 0; k < count; ++k)
+            _valid_dig(order[k] / 9, order[k] % 9, level);
+    }
+    // Fisher-Yates
+    void shuffle(unsigned * array, unsigned size) {
+        for (unsigned k = size - 1; k > 0; --k) {
+            unsigned other = _rng.below(k + 1);
+            unsigned swap = array[k];
+            array[k] = array[other];
+            array[other] = swap;
+        }
+    }
+    Board& to_play() {
+        return puzzle;
+    }
+    // The level of the puzzle dug so far
+    difficulty level() const {
+        return _level;
+    }
+    Mark mark() {
+        Mark m = { puzzle.mark(), _level };
+        return m;
+    }
+    // Refills every hole dug since `m`, which is closed
+    void undo(const Mark & m) {
+        puzzle.undo(m.board);
+        _level = m.level;
+    }
+private:
+    Board puzzle;
+    Trail _trail;
+    Random & _rng;
+    difficulty _level;
+
+    // Each trial solve runs on the puzzle itself and is rolled back through
+    // the trail, so a dig copies no board and allocates nothing
+    void _valid_dig(unsigned i, unsigned j, difficulty level) {
+        unsigned val = puzzle.unset(i, j);
+        if (level == EASY) {
+            TrailMark trial = puzzle.mark();
+            puzzle.hidden_fill();
+            bool solved = !puzzle.remaining();
+            puzzle.undo(trial);
+            if (!solved)
+                puzzle.set(i, j, val);
+            return;
+        }
+        if (puzzle.count_solutions(2) > 1) {
+            puzzle.set(i, j, val);
+            return;
+        }
+        if (_level == EVIL)
+            return;
+        TrailMark trial = puzzle.mark();
+        difficulty rated = rate_in_place(puzzle).level();
+        puzzle.undo(trial);
+        if (level != DEFAULT && rated > level)
+            puzzle.set(i, j, val);
+        else
+            _level = rated;
+    }
+};
+
+// Generates a puzzle of `level` into `puzzle`, with its solution in
+// `answer`. The first `fixed_digs` cells of a random order are dug once;
+// the rest are dug again in a new order up to `attempts` times, stopping
+// as soon as the puzzle rates at `level`. Otherwise the closest puzzle
+// found is kept: the highest level below `level`, then the most holes.
+// Each attempt is rolled back to the fixed digs through the trail; a board
+// is copied only when an attempt beats the best so far.
+static inline void generate_puzzle(difficulty level, Random & rng,
+                                   Board & puzzle, Board & answer) {
+    static const unsigned fixed_digs = 30, attempts = 16;
+    answer = Board(rng);
+    unsigned order[81];
+    for (unsigned c = 0; c < 81; ++c)
+        order[c] = c;
+    Holes game(answer, rng);
+    game.shuffle(order, 81);
+    game.digHoles(level, order, fixed_digs);
+    Holes::Mark base = game.mark();
+
+    difficulty best = DEFAULT;
+    unsigned best_open = 0;
+    for (unsigned k = 0; k < attempts; ++k) {
+        if (k) {
+            game.undo(base);
+            base = game.mark();
+            game.shuffle(order + fixed_digs, 81 - fixed_digs);
+        }
+        game.digHoles(level, order + fixed_digs, 81 - fixed_digs);
+        unsigned open = game.to_play().remaining();
+        if (game.level() > best || (game.level() == best && open > best_open)) {
+            best = game.level();
+            best_open = open;
+            puzzle = game.to_play();
+            puzzle.trail_to(0);
+        }
+        if (level == DEFAULT || level == EASY || best == level)
+            return;
+    }
+}
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "Bits.hpp"
+#include "Simd.hpp"
+
+// Runs naked and hidden singles on sixteen independent puzzles at once.
+// Every array below is structure-of-arrays: entry [x][lane] belongs to the
+// puzzle in that lane, so one Lanes16 operation advances all of them. Each
+// round computes the candidates of every cell, then places every single it
+// found, re-checking each placement against the houses so that two deductions
+// from the same round never clash. Rounds repeat while any lane progresses;
+// puzzles left incomplete are meant to be finished by the scalar solver.
+class Lockstep {
+public:
+    static const unsigned width = 16;
+
+    Lockstep() {
+        clear();
+    }
+    // Empties every lane
+    void clear() {
+        for (unsigned k = 0; k < 9; ++k) {
+            Lanes16::all(allSet).store(_rows[k]);
+            Lanes16::all(allSet).store(_cols[k]);
+            Lanes16::all(allSet).store(_blocks[k]);
+        }
+        for (unsigned c = 0; c < 81; ++c) {
+            Lanes16::zero().store(_value[c]);
+            Lanes16::all(0xFFFF).store(_open[c]);
+        }
+    }
+    // Puts a puzzle (81 cells, 0 for blanks) into `lane`. Returns false if
+    // its givens clash, leaving the lane to be reloaded.
+    bool load(unsigned lane, const unsigned char cells[81]) {
+        for (unsigned k = 0; k < 9; ++k)
+            _rows[k][lane] = _cols[k][lane] = _blocks[k][lane] = allSet;
+        bool valid = true;
+        for (unsigned c = 0; c < 81; ++c) {
+            _value[c][lane] = 0;
+            _open[c][lane] = 0xFFFF;
+            if (!cells[c])
+                continue;
+            lane_t bit = static_cast<lane_t>(bitFor(cells[c]));
+            unsigned i = c / 9, j = c % 9, b = i / 3 * 3 + j / 3;
+            if (!(_rows[i][lane] & _cols[j][lane] & _blocks[b][lane] & bit))
+                valid = false;
+            _rows[i][lane] &= static_cast<lane_t>(~bit);
+            _cols[j][lane] &= static_cast<lane_t>(~bit);
+            _blocks[b][lane] &= static_cast<lane_t>(~bit);
+            _value[c][lane] = bit;
+            _open[c][lane] = 0;
+        }
+        return valid;
+    }
+    // Places singles in every lane until no lane makes progress. Returns the
+    // number of rounds.
+    unsigned propagate() {
+        unsigned rounds = 0;
+        while (_round())
+            ++rounds;
+        return rounds;
+    }
+    // Copies the grid of `lane` into `cells` (0 for open cells). Returns
+    // true if the puzzle is complete.
+    bool extract(unsigned lane, unsigned char cells[81]) const {
+        bool complete = true;
+        for (unsigned c = 0; c < 81; ++c) {
+            lane_t bit = _value[c][lane];
+            cells[c] = static_cast<unsigned char>(bit ? numFor(bit) : 0);
+            if (!bit)
+                complete = false;
+        }
+        return complete;
+    }
+private:
+    // Digits still missing from each house
+    lane_t _rows[9][width], _cols[9][width], _blocks[9][width];
+    // Placed digit as a single bit, or 0
+    lane_t _value[81][width];
+    // All ones while the cell is blank
+    lane_t _open[81][width];
+    lane_t _cand[81][width];
+
+    bool _round() {
+        Tally row_tally, col_tally[9], block_tally[9];
+        Lanes16 row_single[9], col_single[9], block_single[9];
+        for (unsigned k = 0; k < 9; ++k)
+            col_tally[k] = block_tally[k] = Tally::of(Lanes16::zero());
+
+        for (unsigned i = 0; i < 9; ++i) {
+            Lanes16 row = Lanes16::load(_rows[i]);
+            row_tally = Tally::of(Lanes16::zero());
+            for (unsigned j = 0; j < 9; ++j) {
+                unsigned c = 9 * i + j, b = i / 3 * 3 + j / 3;
+                Lanes16 cand = row & Lanes16::load(_cols[j]) &
+                    Lanes16::load(_blocks[b]) & Lanes16::load(_open[c]);
+                cand.store(_cand[c]);
+                row_tally.add(Tally::of(cand));
+                col_tally[j].add(Tally::of(cand));
+                block_tally[b].add(Tally::of(cand));
+            }
+            row_single[i] = row_tally.single();
+        }
+        for (unsigned k = 0; k < 9; ++k) {
+            col_single[k] = col_tally[k].single();
+            block_single[k] = block_tally[k].single();
+        }
+
+        Lanes16 zero = Lanes16::zero(), one = Lanes16::all(1);
+        Lanes16 progress = zero;
+        for (unsigned i = 0; i < 9; ++i) {
+            Lanes16 row = Lanes16::load(_rows[i]);
+            for (unsigned j = 0; j < 9; ++j) {
+                unsigned c = 9 * i + j, b = i / 3 * 3 + j / 3;
+                Lanes16 cand = Lanes16::load(_cand[c]);
+                // Naked single: one candidate left
+                Lanes16 naked = (cand == zero).andnot((cand & (cand - one)) == zero);
+                // Hidden single: the only place for a digit in some house;
+                // keep the lowest if several claim the cell
+                Lanes16 hidden = cand & (row_single[i] | col_single[j] | block_single[b]);
+                hidden = hidden & (zero - hidden);
+                Lanes16 col = Lanes16::load(_cols[j]), block = Lanes16::load(_blocks[b]);
+                Lanes16 place = ((naked & cand) | naked.andnot(hidden)) &
+                    row & col & block & Lanes16::load(_open[c]);
+                if (!place.any())
+                    continue;
+                Lanes16 blank = place == zero;
+                (Lanes16::load(_value[c]) | place).store(_value[c]);
+                (Lanes16::load(_open[c]) & blank).store(_open[c]);
+                row = place.andnot(row);
+                place.andnot(col).store(_cols[j]);
+                place.andnot(block).store(_blocks[b]);
+                progress = progress | place;
+            }
+            row.store(_rows[i]);
+        }
+        return progress.any();
+    }
+};
+
+#endif
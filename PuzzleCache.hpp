@@ -0,0 +1,157 @@
+#ifndef PUZZLE_CACHE_H
+#define PUZZLE_CACHE_H
+
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Canonical.hpp"
+#include "Holes.hpp"
+
+// What is known about a puzzle: its number of solutions (0, 1, or 2 for
+// two or more), one solution when there is one, and its rated level
+struct PuzzleFacts {
+    unsigned char solution[81];
+    unsigned solutions;
+    difficulty level;
+};
+
+// A bounded LRU of solved puzzles keyed by canonical form (Canonical.hpp),
+// so a puzzle that is an earlier one relabeled, reflected or with its
+// lines swapped is answered by mapping the stored solution back. The
+// entries are split over shards by hash, each with its own lock and its
+// own least-recently-used order, so threads rarely wait on each other. A
+// puzzle is solved outside the lock; two threads missing on the same one
+// both solve it and the second store wins.
+class PuzzleCache {
+public:
+    // Small caches get fewer shards, so that the hash spreading entries
+    // unevenly does not evict from one shard while another has room
+    PuzzleCache(std::size_t capacity, unsigned shards = 16)
+        : _shards(_shard_count(capacity, shards)), _hits(0), _misses(0) {
+        _shard_capacity = capacity / _shards.size();
+        if (!_shard_capacity)
+            _shard_capacity = 1;
+    }
+    // The facts about `puzzle` (81 cells, 0 for blanks) in its own
+    // coordinates
+    void solve(const unsigned char puzzle[81], PuzzleFacts & facts) {
+        Key key;
+        Transform t;
+        Canonicalizer().run(puzzle, key.cells, t);
+        std::size_t hash = key.hash();
+        Shard & shard = _shards[hash % _shards.size()];
+        PuzzleFacts found;
+        if (_find(shard, key, found)) {
+            ++_hits;
+        } else {
+            ++_misses;
+            _solve(key.cells, found);
+            _store(shard, key, found);
+        }
+        facts.solutions = found.solutions;
+        facts.level = found.level;
+        if (found.solutions)
+            t.revert(found.solution, facts.solution);
+    }
+    unsigned long hits() const {
+        return _hits;
+    }
+    unsigned long misses() const {
+        return _misses;
+    }
+private:
+    struct Key {
+        unsigned char cells[81];
+
+        bool operator==(const Key & other) const {
+            return std::memcmp(cells, other.cells, 81) == 0;
+        }
+        // FNV-1a
+        std::size_t hash() const {
+            std::uint64_t h = 14695981039346656037ull;
+            for (unsigned k = 0; k < 81; ++k)
+                h = (h ^ cells[k]) * 1099511628211ull;
+            return static_cast<std::size_t>(h ^ h >> 32);
+        }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key & key) const {
+            return key.hash();
+        }
+    };
+    struct Entry {
+        Key key;
+        PuzzleFacts facts;
+    };
+    typedef std::list<Entry> Entries;
+    struct Shard {
+        std::mutex lock;
+        // Most recently used first
+        Entries entries;
+        std::unordered_map<Key, Entries::iterator, KeyHash> index;
+    };
+
+    std::vector<Shard> _shards;
+    std::size_t _shard_capacity;
+    std::atomic<unsigned long> _hits, _misses;
+
+    static std::size_t _shard_count(std::size_t capacity, unsigned shards) {
+        std::size_t most = capacity / 256;
+        if (most < shards)
+            return most ? most : 1;
+        return shards;
+    }
+    static bool _find(Shard & shard, const Key & key, PuzzleFacts & facts) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.index.find(key);
+        if (found == shard.index.end())
+            return false;
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        facts = found->second->facts;
+        return true;
+    }
+    void _store(Shard & shard, const Key & key, const PuzzleFacts & facts) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            found->second->facts = facts;
+            shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+            return;
+        }
+        if (shard.entries.size() == _shard_capacity) {
+            shard.index.erase(shard.entries.back().key);
+            shard.entries.pop_back();
+        }
+        Entry entry = { key, facts };
+        shard.entries.push_front(entry);
+        shard.index[key] = shard.entries.begin();
+    }
+    // Logic once for both the rating and the search: what logic places
+    // holds in every solution, so counting from there counts the puzzle's
+    static void _solve(const unsigned char cells[81], PuzzleFacts & facts) {
+        Board board;
+        facts.solutions = 0;
+        facts.level = DEFAULT;
+        for (unsigned k = 0; k < 81; ++k)
+            if (cells[k]) {
+                if (!board.mask_check(k / 9, k % 9, bitFor(cells[k])))
+                    return;
+                board.set(k / 9, k % 9, cells[k]);
+            }
+        Rating rating = rate_in_place(board);
+        facts.solutions = board.count_solutions(2);
+        if (facts.solutions && board.remaining() && !board.backtrack())
+            facts.solutions = 0;
+        if (!facts.solutions)
+            return;
+        facts.level = rating.level();
+        for (unsigned k = 0; k < 81; ++k)
+            facts.solution[k] = static_cast<unsigned char>(board.get_num(k / 9, k % 9));
+    }
+};
+
+#endif
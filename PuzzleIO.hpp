@@ -0,0 +1,326 @@
+#ifndef PUZZLE_IO_H
+#define PUZZLE_IO_H
+
+#include <cstdio>
+#include <cstring>
+
+// Reads a stream line by line through one fixed buffer. The returned line
+// points into the buffer and stays valid until the next call.
+class LineReader {
+public:
+    static const unsigned capacity = 1 << 16;
+
+    LineReader(std::FILE * in)
+        : _in(in), _begin(0), _end(0), _line(0), _eof(false), _skip(false) {
+    }
+    bool next(const char *& line, unsigned & length) {
+        while (true) {
+            char * newline = static_cast<char *>(
+                std::memchr(_buffer + _begin, '\n', _end - _begin));
+            unsigned size = newline ? static_cast<unsigned>(newline - _buffer) - _begin
+                                    : _end - _begin;
+            if (_skip) {
+                // Drop the tail of a line that did not fit into the buffer
+                _begin += newline ? size + 1 : size;
+                if (newline)
+                    _skip = false;
+            } else if (newline || (_eof && size) || size == capacity) {
+                line = _buffer + _begin;
+                length = size;
+                _begin += newline ? size + 1 : size;
+                _skip = !newline && !_eof;
+                ++_line;
+                return true;
+            }
+            if (_eof && _begin == _end)
+                return false;
+            if (!newline)
+                _refill();
+        }
+    }
+    unsigned long line_number() {
+        return _line;
+    }
+private:
+    std::FILE * _in;
+    char _buffer[capacity];
+    unsigned _begin, _end;
+    unsigned long _line;
+    bool _eof, _skip;
+
+    void _refill() {
+        std::memmove(_buffer, _buffer + _begin, _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+        std::size_t got = std::fread(_buffer + _end, 1, capacity - _end, _in);
+        _end += static_cast<unsigned>(got);
+        if (got == 0)
+            _eof = true;
+    }
+};
+
+// Collects output in one fixed buffer and hands it to the stream in large
+// writes instead of per-cell insertions.
+class OutputBuffer {
+public:
+    static const unsigned capacity = 1 << 16;
+
+    OutputBuffer(std::FILE * out)
+        : _out(out), _size(0) {
+    }
+    ~OutputBuffer() {
+        flush();
+    }
+    void write(const char * data, unsigned length) {
+        if (_size + length > capacity)
+            flush();
+        std::memcpy(_buffer + _size, data, length);
+        _size += length;
+    }
+    void put(char c) {
+        if (_size == capacity)
+            flush();
+        _buffer[_size++] = c;
+    }
+    void flush() {
+        if (_size)
+            std::fwrite(_buffer, 1, _size, _out);
+        _size = 0;
+    }
+private:
+    std::FILE * _out;
+    char _buffer[capacity];
+    unsigned _size;
+};
+
+// The cell a character stands for: 1-9 for a given, 0 for a blank ('0' or
+// '.'), -1 for anything else
+static inline int cell_value(char c) {
+    if (c >= '1' && c <= '9')
+        return c - '0';
+    return c == '0' || c == '.' ? 0 : -1;
+}
+
+// Parses the one-line format: 81 cells, '1'-'9' for givens and '0' or '.'
+// for blanks, optionally followed by whitespace.
+static inline bool parse_line(const char * line, unsigned length, unsigned char cells[81]) {
+    while (length && (line[length - 1] == '\r' || line[length - 1] == ' ' ||
+                      line[length - 1] == '\t'))
+        --length;
+    if (length != 81)
+        return false;
+    for (unsigned k = 0; k < 81; ++k) {
+        int value = cell_value(line[k]);
+        if (value < 0)
+            return false;
+        cells[k] = static_cast<unsigned char>(value);
+    }
+    return true;
+}
+
+// Where and why a puzzle could not be read
+struct ParseError {
+    unsigned long line;
+    const char * message;
+};
+
+// Assembles puzzles from lines of text in either format: one line of 81
+// cells, or nine lines of nine cells, the format of the files the
+// interactive mode imports. Cells may be separated by spaces or tabs;
+// blank lines and lines starting with '#' are skipped. A line that does
+// not fit is reported by number instead of being read as blanks. Inside a
+// grid, a bad row still counts as one of its nine, so the error is
+// reported once the grid ends and the following puzzles stay in step. A
+// bad first line that is nearer a row of 9 than 81 cells, and mostly
+// cells, opens a grid the same way; a blank line ends a grid that has
+// already gone wrong. A whole one-line puzzle ends any grid in progress
+// as malformed and is then read on its own, so a truncated line among
+// one-line puzzles costs only itself.
+class PuzzleParser {
+public:
+    enum status { MORE, PUZZLE, FAILED };
+
+    PuzzleParser()
+        : _rows(0), _first(0), _last(0), _held_line(0), _holding(false) {
+        _error.line = 0;
+        _error.message = 0;
+    }
+    // Takes line `number`. PUZZLE means `cells` now holds a whole puzzle
+    // that began on first_line(); FAILED means the puzzle that began there
+    // is malformed, see error(). After FAILED, holding() tells whether the
+    // line was a puzzle of its own that resume() returns.
+    status feed(const char * line, unsigned length, unsigned long number,
+                unsigned char cells[81]) {
+        while (length && (line[length - 1] == '\r' || line[length - 1] == ' ' ||
+                          line[length - 1] == '\t'))
+            --length;
+        if (!length && _rows && _error.message) {
+            _rows = 0;
+            return FAILED;
+        }
+        if (!length || line[0] == '#')
+            return MORE;
+        if (!_rows) {
+            _first = number;
+            _error.message = 0;
+        }
+        unsigned char * row = cells + 9 * _rows;
+        unsigned count = 0, good = 0;
+        const char * bad = 0;
+        for (unsigned k = 0; k < length; ++k) {
+            char c = line[k];
+            if (c == ' ' || c == '\t')
+                continue;
+            int value = cell_value(c);
+            if (value < 0) {
+                bad = "unexpected character";
+            } else {
+                if (count < 81 - 9 * _rows)
+                    row[count] = static_cast<unsigned char>(value);
+                ++good;
+            }
+            ++count;
+        }
+        if (!bad && count == 81 && !_rows)
+            return PUZZLE;
+        if (!bad && count == 81) {
+            _hold(line, length, number);
+            _rows = 0;
+            if (!_error.message)
+                _fail(_last, "grid ends before its ninth row");
+            return FAILED;
+        }
+        if (!bad && count != 9)
+            bad = _rows ? "expected 9 cells in a grid row" : "expected 81 cells or a row of 9";
+        if (bad && !_rows && (2 * count > 9 + 81 || 2 * good <= count))
+            return _fail(number, bad);
+        if (bad && !_error.message) {
+            _error.line = number;
+            _error.message = bad;
+        }
+        _last = number;
+        if (++_rows < 9)
+            return MORE;
+        _rows = 0;
+        return _error.message ? FAILED : PUZZLE;
+    }
+    // Reads lines from `reader` up to the next puzzle and returns it as
+    // feed does, or MORE once the input is used up
+    status next(LineReader & reader, unsigned char cells[81]) {
+        if (_holding)
+            return resume(cells);
+        const char * line;
+        unsigned length;
+        while (reader.next(line, length)) {
+            status result = feed(line, length, reader.line_number(), cells);
+            if (result != MORE)
+                return result;
+        }
+        return finish(reader.line_number());
+    }
+    bool holding() const {
+        return _holding;
+    }
+    // The one-line puzzle that ended a grid early, as PUZZLE
+    status resume(unsigned char cells[81]) {
+        std::memcpy(cells, _held, 81);
+        _first = _held_line;
+        _holding = false;
+        return PUZZLE;
+    }
+    // Ends the input after line `number`. Returns FAILED if it stopped in
+    // the middle of a grid, MORE otherwise.
+    status finish(unsigned long number) {
+        if (!_rows)
+            return MORE;
+        _rows = 0;
+        if (!_error.message)
+            _fail(number, "grid ends before its ninth row");
+        return FAILED;
+    }
+    unsigned long first_line() {
+        return _first;
+    }
+    const ParseError & error() {
+        return _error;
+    }
+private:
+    unsigned _rows;
+    unsigned long _first;
+    // The line of the grid row fed last
+    unsigned long _last;
+    ParseError _error;
+    unsigned char _held[81];
+    unsigned long _held_line;
+    bool _holding;
+
+    status _fail(unsigned long number, const char * message) {
+        _error.line = number;
+        _error.message = message;
+        return FAILED;
+    }
+    // Keeps a whole one-line puzzle for resume()
+    void _hold(const char * line, unsigned length, unsigned long number) {
+        unsigned count = 0;
+        for (unsigned k = 0; k < length; ++k)
+            if (line[k] != ' ' && line[k] != '\t')
+                _held[count++] = static_cast<unsigned char>(cell_value(line[k]));
+        _held_line = number;
+        _holding = true;
+    }
+};
+
+// Reads the first puzzle in text[0, length) into `cells`, in either format
+// PuzzleParser takes. Returns false with `error` set if there is none or it
+// is malformed.
+static inline bool parse_puzzle(const char * text, std::size_t length,
+                                unsigned char cells[81], ParseError & error) {
+    PuzzleParser parser;
+    const char * end = text + length;
+    unsigned long number = 0;
+    PuzzleParser::status status = PuzzleParser::MORE;
+    while (text < end && status == PuzzleParser::MORE) {
+        const char * newline = static_cast<const char *>(std::memchr(text, '\n', end - text));
+        const char * stop = newline ? newline : end;
+        status = parser.feed(text, static_cast<unsigned>(stop - text), ++number, cells);
+        text = newline ? newline + 1 : end;
+    }
+    if (status == PuzzleParser::MORE)
+        status = parser.finish(number);
+    if (status == PuzzleParser::PUZZLE)
+        return true;
+    error = parser.error();
+    if (!error.message) {
+        error.line = number;
+        error.message = "no puzzle";
+    }
+    return false;
+}
+
+// Formats `cells` as one line of 81 characters, '.' for blanks, and a
+// newline
+static inline void format_line(const unsigned char cells[81], char text[82]) {
+    for (unsigned k = 0; k < 81; ++k)
+        text[k] = static_cast<char>(cells[k] ? '0' + cells[k] : '.');
+    text[81] = '\n';
+}
+
+// Characters format_grid writes: nine rows of 19 and an empty line
+static const unsigned grid_text_size = 9 * 19 + 1;
+
+// Formats `cells` as nine rows of space-separated digits, 0 for blanks,
+// followed by an empty line: the layout the interactive mode shows and
+// imports
+static inline void format_grid(const unsigned char cells[81], char text[grid_text_size]) {
+    for (unsigned i = 0; i < 9; ++i) {
+        char * row = text + 19 * i;
+        for (unsigned j = 0; j < 9; ++j) {
+            row[2 * j] = static_cast<char>('0' + cells[9 * i + j]);
+            row[2 * j + 1] = ' ';
+        }
+        row[18] = '\n';
+    }
+    text[grid_text_size - 1] = '\n';
+}
+
+#endif
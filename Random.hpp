@@ -0,0 +1,58 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// xoshiro128** seeded through splitmix64. A generator is keyed by a master
+// seed and a stream number, so every task can own an independent sequence
+// that is reproduced exactly from the same (seed, stream) pair, whatever
+// thread runs it.
+class Random {
+public:
+    typedef std::uint32_t result_type;
+
+    explicit Random(std::uint64_t seed, std::uint64_t stream = 0) {
+        std::uint64_t x = seed;
+        x = _splitmix(x) ^ stream;
+        for (unsigned k = 0; k < 4; k += 2) {
+            std::uint64_t v = _splitmix(x);
+            _s[k] = static_cast<std::uint32_t>(v);
+            _s[k + 1] = static_cast<std::uint32_t>(v >> 32);
+        }
+    }
+    static result_type min() {
+        return 0;
+    }
+    static result_type max() {
+        return 0xFFFFFFFFu;
+    }
+    result_type operator()() {
+        std::uint32_t result = _rotl(_s[1] * 5, 7) * 9;
+        std::uint32_t t = _s[1] << 9;
+        _s[2] ^= _s[0];
+        _s[3] ^= _s[1];
+        _s[1] ^= _s[2];
+        _s[0] ^= _s[3];
+        _s[2] ^= t;
+        _s[3] = _rotl(_s[3], 11);
+        return result;
+    }
+    // Uniform in [0, n) by multiply-shift; the bias is below n / 2^32
+    unsigned below(unsigned n) {
+        return static_cast<unsigned>((static_cast<std::uint64_t>((*this)()) * n) >> 32);
+    }
+private:
+    std::uint32_t _s[4];
+
+    static std::uint32_t _rotl(std::uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+    static std::uint64_t _splitmix(std::uint64_t & x) {
+        std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+};
+
+#endif
@@ -0,0 +1,606 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Generator.hpp"
+#include "Hints.hpp"
+#include "Solver.hpp"
+
+// Answers one request line of the solver protocol. Puzzles are one line of
+// 81 cells as `Sudoku -b` reads them. Every request gets exactly one reply
+// line, "ok ..." or "err <reason>":
+//
+//   solve <puzzle>         ok <solution>
+//   validate <puzzle>      ok unique | ok multiple | ok none
+//   rate <puzzle>          ok <level> <singles> <advanced> <search>
+//   hint <puzzle>          ok <step>, as the interactive hint prints it
+//   generate <level> [<seed> <index>]
+//                          ok <puzzle> <solution>
+//
+// `generate` with a seed and index gives the puzzle `Sudoku -g -s seed -i
+// index` prints; without them, the next index of the service's own seed.
+// An instance is shared by every worker; answer() keeps no state but that
+// counter.
+class SolverService {
+public:
+    // Room for the longest reply, a hint
+    static const unsigned reply_capacity = 16 + Hint::text_capacity;
+
+    SolverService(std::uint64_t seed, engine e = PIPELINE)
+        : _seed(seed), _engine(e), _next(0) {
+    }
+    // Writes the reply to `line` into `reply`, without a newline, and
+    // returns its length
+    unsigned answer(const char * line, unsigned length, char * reply) {
+        const char * space = static_cast<const char *>(std::memchr(line, ' ', length));
+        unsigned op = space ? static_cast<unsigned>(space - line) : length;
+        const char * arg = space ? space + 1 : line + length;
+        unsigned arg_length = length - (space ? op + 1 : op);
+        if (_is(line, op, "generate"))
+            return _generate(arg, arg_length, reply);
+        unsigned char cells[81];
+        Board board;
+        if (!_is(line, op, "solve") && !_is(line, op, "validate") && !_is(line, op, "rate") &&
+            !_is(line, op, "hint"))
+            return _error(reply, "unknown request");
+        if (!parse_line(arg, arg_length, cells))
+            return _error(reply, "malformed puzzle");
+        bool loaded = load_cells(cells, board);
+        if (_is(line, op, "validate")) {
+            unsigned solutions = loaded ? board.count_solutions(2) : 0;
+            return _ok(reply, solutions == 1 ? "unique" : solutions ? "multiple" : "none");
+        }
+        if (!loaded)
+            return _error(reply, "givens clash");
+        if (_is(line, op, "rate")) {
+            Rating rating = rate_puzzle(board);
+            return static_cast<unsigned>(std::snprintf(
+                reply, reply_capacity, "ok %s %u %u %u", difficulty_name(rating.level()),
+                rating.singles, rating.advanced, rating.search));
+        }
+        if (_is(line, op, "hint"))
+            return _hint(board, reply);
+        if (!solve_board(board, _engine))
+            return _error(reply, "no solution");
+        return _ok(reply, board);
+    }
+private:
+    std::uint64_t _seed;
+    engine _engine;
+    std::atomic<unsigned long> _next;
+
+    static bool _is(const char * op, unsigned length, const char * name) {
+        return std::strlen(name) == length && std::memcmp(op, name, length) == 0;
+    }
+    static unsigned _reply(char * reply, const char * status, const char * what) {
+        return static_cast<unsigned>(std::snprintf(reply, reply_capacity, "%s %s", status, what));
+    }
+    static unsigned _ok(char * reply, const char * what) {
+        return _reply(reply, "ok", what);
+    }
+    static unsigned _error(char * reply, const char * what) {
+        return _reply(reply, "err", what);
+    }
+    static unsigned _ok(char * reply, Board & board) {
+        unsigned char cells[81];
+        for (unsigned k = 0; k < 81; ++k)
+            cells[k] = static_cast<unsigned char>(board.get_num(k / 9, k % 9));
+        std::memcpy(reply, "ok ", 3);
+        format_line(cells, reply + 3);
+        return 84;
+    }
+    unsigned _hint(Board & board, char * reply) {
+        Board answer = board;
+        if (board.count_solutions(2) != 1)
+            return _error(reply, "no unique solution");
+        solve_board(answer);
+        HintEngine hints;
+        hints.start(board, answer);
+        Hint hint;
+        if (!hints.next(hint))
+            return _error(reply, "puzzle is complete");
+        std::memcpy(reply, "ok ", 3);
+        return 3 + hint.format(reply + 3);
+    }
+    unsigned _generate(const char * arg, unsigned length, char * reply) {
+        char text[64];
+        if (length >= sizeof text)
+            return _error(reply, "malformed request");
+        std::memcpy(text, arg, length);
+        text[length] = 0;
+        char name[16];
+        unsigned long long seed;
+        unsigned long index;
+        int fields = std::sscanf(text, "%15s %llu %lu", name, &seed, &index);
+        difficulty level = DEFAULT;
+        bool known = false;
+        for (unsigned k = EASY; fields >= 1 && k <= EVIL && !known; ++k)
+            if (std::strcmp(name, difficulty_name(static_cast<difficulty>(k))) == 0) {
+                level = static_cast<difficulty>(k);
+                known = true;
+            }
+        if (!known)
+            return _error(reply, "unknown level");
+        if (fields == 2)
+            return _error(reply, "generate takes a seed and an index or neither");
+        if (fields < 3) {
+            seed = _seed;
+            index = _next++;
+        }
+        Random rng = puzzle_random(seed, level, index);
+        Board puzzle, solution;
+        generate_puzzle(level, rng, puzzle, solution);
+        unsigned char cells[81];
+        std::memcpy(reply, "ok ", 3);
+        for (unsigned k = 0; k < 81; ++k)
+            cells[k] = static_cast<unsigned char>(puzzle.get_num(k / 9, k % 9));
+        format_line(cells, reply + 3);
+        reply[84] = ' ';
+        for (unsigned k = 0; k < 81; ++k)
+            cells[k] = static_cast<unsigned char>(solution.get_num(k / 9, k % 9));
+        format_line(cells, reply + 85);
+        return 166;
+    }
+};
+
+// Serves SolverService over a local TCP port or Unix socket. One thread
+// runs an epoll loop over every connection; the requests it reads in one
+// round, from all connections, are handed to a work-stealing pool in
+// batches, and the workers wake the loop through an eventfd when a batch is
+// done. Clients may pipeline: replies come back in request order on each
+// connection however the batches finish. A connection with too many
+// requests in flight is not read from until its replies drain, so memory
+// stays bounded. SIGINT and SIGTERM stop the loop cleanly.
+class SolverServer {
+public:
+    // The most requests handed to a worker at once
+    static const unsigned batch_size = 32;
+    // Requests one connection may have waiting for replies
+    static const unsigned pipeline_limit = 1024;
+    static const unsigned line_capacity = 256;
+    static const unsigned input_capacity = 1 << 14;
+
+    SolverServer(SolverService & service, unsigned threads)
+        : served(0), _service(service), _threads(threads ? threads : 1),
+          _listen(-1), _epoll(-1), _wake(-1), _signals(-1), _unix(false) {
+    }
+    ~SolverServer() {
+        _pool.reset();
+        for (std::unordered_set<Connection *>::iterator c = _connections.begin();
+             c != _connections.end(); ++c) {
+            if ((*c)->fd >= 0)
+                ::close((*c)->fd);
+            for (unsigned k = 0; k < (*c)->pending.size(); ++k)
+                delete (*c)->pending[k];
+            delete *c;
+        }
+        for (unsigned k = 0; k < _free.size(); ++k)
+            delete _free[k];
+        int fds[] = { _listen, _epoll, _wake, _signals };
+        for (unsigned k = 0; k < 4; ++k)
+            if (fds[k] >= 0)
+                ::close(fds[k]);
+        if (_unix)
+            ::unlink(_path.c_str());
+    }
+    // Listens on 127.0.0.1:`port`, any free port for 0. Returns false and
+    // sets error() if it cannot.
+    bool listen_tcp(unsigned port) {
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof address);
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        _listen = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int on = 1;
+        if (_listen < 0 || ::setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) ||
+            ::bind(_listen, reinterpret_cast<sockaddr *>(&address), sizeof address) ||
+            ::listen(_listen, SOMAXCONN))
+            return _fail("cannot listen");
+        socklen_t size = sizeof address;
+        ::getsockname(_listen, reinterpret_cast<sockaddr *>(&address), &size);
+        _port = ntohs(address.sin_port);
+        return true;
+    }
+    // Listens on a Unix socket at `path`, replacing a stale socket there.
+    // Any other kind of file at `path` is left alone and reported, with
+    // errno set to EADDRINUSE.
+    bool listen_unix(const char * path) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        if (std::strlen(path) >= sizeof address.sun_path)
+            return _fail("socket path too long");
+        std::strcpy(address.sun_path, path);
+        struct stat info;
+        if (::lstat(path, &info) == 0) {
+            if (!S_ISSOCK(info.st_mode)) {
+                errno = EADDRINUSE;
+                return _fail("path exists and is not a socket");
+            }
+            ::unlink(path);
+        }
+        _listen = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (_listen < 0 || ::bind(_listen, reinterpret_cast<sockaddr *>(&address), sizeof address) ||
+            ::listen(_listen, SOMAXCONN))
+            return _fail("cannot listen");
+        _unix = true;
+        _path = path;
+        return true;
+    }
+    // The TCP port listen_tcp bound
+    unsigned port() const {
+        return _port;
+    }
+    const char * error() const {
+        return _error;
+    }
+    // Serves until SIGINT or SIGTERM. Returns false and sets error() if the
+    // loop cannot be set up.
+    bool run() {
+        // Blocked before the pool starts, so only the signalfd sees them
+        sigset_t stops;
+        sigemptyset(&stops);
+        sigaddset(&stops, SIGINT);
+        sigaddset(&stops, SIGTERM);
+        sigaddset(&stops, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &stops, 0);
+        sigdelset(&stops, SIGPIPE);
+        _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        _wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        _signals = ::signalfd(-1, &stops, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (_epoll < 0 || _wake < 0 || _signals < 0 || !_add(_listen, &_listen) ||
+            !_add(_wake, &_wake) || !_add(_signals, &_signals))
+            return _fail("cannot set up the event loop");
+        _pool.reset(new ThreadPool(_threads));
+        epoll_event events[64];
+        bool stopping = false;
+        while (!stopping) {
+            int count = ::epoll_wait(_epoll, events, 64, -1);
+            if (count < 0 && errno != EINTR)
+                return _fail("epoll_wait failed");
+            for (int k = 0; k < count; ++k) {
+                void * source = events[k].data.ptr;
+                if (source == &_listen)
+                    _accept();
+                else if (source == &_wake)
+                    _complete();
+                else if (source == &_signals)
+                    stopping = true;
+                else if (static_cast<Connection *>(source)->fd >= 0)
+                    _serve(*static_cast<Connection *>(source), events[k].events);
+            }
+            // Freed only now, as later events of the round may name them
+            for (unsigned k = 0; k < _released.size(); ++k)
+                delete _released[k];
+            _released.clear();
+            _dispatch();
+        }
+        return true;
+    }
+
+    // Requests answered so far
+    unsigned long served;
+private:
+    struct Connection;
+
+    struct Request {
+        Connection * connection;
+        char line[line_capacity];
+        char reply[SolverService::reply_capacity + 1];
+        unsigned length, reply_length;
+        bool done;
+    };
+
+    struct Connection {
+        int fd;
+        unsigned events;
+        char input[input_capacity];
+        unsigned input_size;
+        // Requests in arrival order; the done ones at the front are replied
+        std::deque<Request *> pending;
+        unsigned in_flight;
+        std::string output;
+        std::size_t sent;
+        // Reading stops at end of input or while too much is pending; a
+        // connection whose fd is gone lingers until its requests finish
+        bool reading, ended, skipping, touched;
+    };
+
+    SolverService & _service;
+    unsigned _threads;
+    int _listen, _epoll, _wake, _signals;
+    bool _unix;
+    std::string _path;
+    unsigned _port;
+    const char * _error;
+    std::unordered_set<Connection *> _connections;
+    // Recycled requests, so a steady load allocates nothing
+    std::vector<Request *> _free;
+    // Requests read this round, not yet handed to the pool
+    std::vector<Request *> _batch;
+    std::mutex _completed_lock;
+    std::vector<Request *> _completed;
+    std::vector<Request *> _finished;
+    std::vector<Connection *> _touched;
+    // Connections released this round, deleted once it is over
+    std::vector<Connection *> _released;
+    std::unique_ptr<ThreadPool> _pool;
+
+    bool _fail(const char * what) {
+        _error = what;
+        return false;
+    }
+    bool _add(int fd, void * source) {
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = source;
+        return ::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) == 0;
+    }
+    void _accept() {
+        while (true) {
+            int fd = ::accept4(_listen, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            if (!_unix) {
+                int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+            }
+            Connection * c = new Connection;
+            c->fd = fd;
+            c->events = EPOLLIN;
+            c->input_size = 0;
+            c->in_flight = 0;
+            c->sent = 0;
+            c->reading = true;
+            c->ended = c->skipping = c->touched = false;
+            if (!_add(fd, c)) {
+                ::close(fd);
+                delete c;
+                continue;
+            }
+            _connections.insert(c);
+        }
+    }
+    // Any of the calls may close the connection. A hung-up socket is closed
+    // whatever the connection waits for, since epoll keeps reporting it
+    // even with no events registered.
+    void _serve(Connection & c, unsigned events) {
+        if (events & (EPOLLHUP | EPOLLERR))
+            _close(c);
+        else if (events & EPOLLIN)
+            _read(c);
+        else
+            _write(c);
+    }
+    void _read(Connection & c) {
+        while (c.reading) {
+            ssize_t got = ::read(c.fd, c.input + c.input_size, input_capacity - c.input_size);
+            if (got > 0) {
+                c.input_size += static_cast<unsigned>(got);
+                _parse(c);
+            } else if (got == 0) {
+                // The client is done sending; finish its replies, then close
+                if (c.input_size && !c.skipping)
+                    _request(c, c.input, c.input_size);
+                c.input_size = 0;
+                c.reading = false;
+                c.ended = true;
+            } else if (errno != EINTR) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    _close(c);
+                    return;
+                }
+                break;
+            }
+        }
+        _write(c);
+    }
+    // Turns the complete lines in the input into requests
+    void _parse(Connection & c) {
+        unsigned start = 0;
+        while (c.pending.size() < pipeline_limit) {
+            char * newline = static_cast<char *>(
+                std::memchr(c.input + start, '\n', c.input_size - start));
+            if (!newline) {
+                // A line that fills the whole buffer is answered at once and
+                // its tail skipped
+                if (c.input_size - start == input_capacity || (c.skipping && start < c.input_size)) {
+                    if (!c.skipping)
+                        _request(c, 0, input_capacity);
+                    c.skipping = true;
+                    start = c.input_size;
+                }
+                break;
+            }
+            unsigned length = static_cast<unsigned>(newline - (c.input + start));
+            if (c.skipping)
+                c.skipping = false;
+            else
+                _request(c, c.input + start, length);
+            start += length + 1;
+        }
+        std::memmove(c.input, c.input + start, c.input_size - start);
+        c.input_size -= start;
+        if (c.pending.size() >= pipeline_limit)
+            c.reading = false;
+    }
+    // Queues one line; a null line stands for one too long to keep
+    void _request(Connection & c, const char * line, unsigned length) {
+        while (line && length && (line[length - 1] == '\r' || line[length - 1] == ' '))
+            --length;
+        if (line && !length)
+            return;
+        Request * request;
+        if (_free.empty()) {
+            request = new Request;
+        } else {
+            request = _free.back();
+            _free.pop_back();
+        }
+        request->connection = &c;
+        c.pending.push_back(request);
+        if (!line || length > line_capacity) {
+            request->reply_length = static_cast<unsigned>(
+                std::snprintf(request->reply, sizeof request->reply, "err line too long"));
+            request->done = true;
+            return;
+        }
+        std::memcpy(request->line, line, length);
+        request->length = length;
+        request->done = false;
+        ++c.in_flight;
+        _batch.push_back(request);
+    }
+    // Splits the round's requests over at least as many tasks as there are
+    // workers, so a burst from one connection still runs in parallel
+    void _dispatch() {
+        std::size_t size = (_batch.size() + _threads - 1) / _threads;
+        if (size > batch_size)
+            size = batch_size;
+        for (std::size_t first = 0; first < _batch.size(); first += size) {
+            std::size_t last = std::min<std::size_t>(first + size, _batch.size());
+            std::vector<Request *> group(_batch.begin() + first, _batch.begin() + last);
+            _pool->submit([this, group] {
+                for (unsigned k = 0; k < group.size(); ++k) {
+                    Request & r = *group[k];
+                    r.reply_length = _service.answer(r.line, r.length, r.reply);
+                }
+                {
+                    std::lock_guard<std::mutex> guard(_completed_lock);
+                    _completed.insert(_completed.end(), group.begin(), group.end());
+                }
+                std::uint64_t one = 1;
+                ssize_t written = ::write(_wake, &one, sizeof one);
+                (void)written;
+            });
+        }
+        _batch.clear();
+    }
+    // Takes the workers' finished requests and sends what is now in order
+    void _complete() {
+        std::uint64_t count;
+        ssize_t got = ::read(_wake, &count, sizeof count);
+        (void)got;
+        {
+            std::lock_guard<std::mutex> guard(_completed_lock);
+            _finished.swap(_completed);
+        }
+        for (unsigned k = 0; k < _finished.size(); ++k) {
+            Request & r = *_finished[k];
+            r.done = true;
+            ++served;
+            --r.connection->in_flight;
+            if (!r.connection->touched) {
+                r.connection->touched = true;
+                _touched.push_back(r.connection);
+            }
+        }
+        _finished.clear();
+        for (unsigned k = 0; k < _touched.size(); ++k) {
+            Connection & c = *_touched[k];
+            c.touched = false;
+            if (c.fd >= 0)
+                _write(c);
+            else
+                _release(c);
+        }
+        _touched.clear();
+    }
+    // Moves the replies that are in order to the output, sends what the
+    // socket takes and updates what the loop watches for. A connection
+    // that drained below the limit takes up the lines it has buffered
+    // here; the socket itself is read again by the loop.
+    void _write(Connection & c) {
+        while (true) {
+            while (!c.pending.empty() && c.pending.front()->done) {
+                Request * r = c.pending.front();
+                c.pending.pop_front();
+                r->reply[r->reply_length] = '\n';
+                c.output.append(r->reply, r->reply_length + 1);
+                _free.push_back(r);
+            }
+            while (c.sent < c.output.size()) {
+                ssize_t put = ::send(c.fd, c.output.data() + c.sent, c.output.size() - c.sent,
+                                     MSG_NOSIGNAL);
+                if (put > 0) {
+                    c.sent += static_cast<std::size_t>(put);
+                } else if (put < 0 && errno == EINTR) {
+                    continue;
+                } else if (put < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    break;
+                } else {
+                    _close(c);
+                    return;
+                }
+            }
+            if (c.sent == c.output.size()) {
+                c.output.clear();
+                c.sent = 0;
+            }
+            if (c.reading || c.ended || c.pending.size() >= pipeline_limit / 2)
+                break;
+            c.reading = true;
+            _parse(c);
+        }
+        if (c.ended && c.pending.empty() && c.output.empty()) {
+            _close(c);
+            return;
+        }
+        unsigned events = (c.reading ? std::uint32_t(EPOLLIN) : 0u) |
+                          (c.output.empty() ? 0u : std::uint32_t(EPOLLOUT));
+        if (events != c.events) {
+            epoll_event event;
+            event.events = events;
+            event.data.ptr = &c;
+            ::epoll_ctl(_epoll, EPOLL_CTL_MOD, c.fd, &event);
+            c.events = events;
+        }
+    }
+    void _close(Connection & c) {
+        ::epoll_ctl(_epoll, EPOLL_CTL_DEL, c.fd, 0);
+        ::close(c.fd);
+        c.fd = -1;
+        c.reading = false;
+        _release(c);
+    }
+    // Frees a closed connection once no worker holds its requests, at the
+    // end of the round
+    void _release(Connection & c) {
+        while (!c.pending.empty() && c.pending.front()->done) {
+            _free.push_back(c.pending.front());
+            c.pending.pop_front();
+        }
+        if (c.in_flight || !_connections.erase(&c))
+            return;
+        _released.push_back(&c);
+    }
+};
+
+#endif
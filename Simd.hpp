@@ -0,0 +1,243 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Sixteen 16-bit lanes with the handful of operations the candidate
+// kernels need. AVX2 holds them in one register, SSE2 in two, and the
+// scalar fallback in a plain array. Define SUDOKU_NO_SIMD to force the
+// fallback.
+#if !defined(SUDOKU_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define SUDOKU_SIMD "avx2"
+#define SUDOKU_SIMD_AVX2 1
+#elif !defined(SUDOKU_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+                                   (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SUDOKU_SIMD "sse2"
+#define SUDOKU_SIMD_SSE2 1
+#else
+#define SUDOKU_SIMD "scalar"
+#endif
+
+typedef unsigned short lane_t;
+
+#if defined(SUDOKU_SIMD_AVX2)
+
+struct Lanes16 {
+    __m256i v;
+
+    static Lanes16 zero() {
+        Lanes16 r = { _mm256_setzero_si256() };
+        return r;
+    }
+    static Lanes16 all(lane_t x) {
+        Lanes16 r = { _mm256_set1_epi16(static_cast<short>(x)) };
+        return r;
+    }
+    static Lanes16 load(const lane_t * p) {
+        Lanes16 r = { _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)) };
+        return r;
+    }
+    void store(lane_t * p) const {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+    }
+    Lanes16 operator&(Lanes16 o) const {
+        Lanes16 r = { _mm256_and_si256(v, o.v) };
+        return r;
+    }
+    Lanes16 operator|(Lanes16 o) const {
+        Lanes16 r = { _mm256_or_si256(v, o.v) };
+        return r;
+    }
+    // ~this & o
+    Lanes16 andnot(Lanes16 o) const {
+        Lanes16 r = { _mm256_andnot_si256(v, o.v) };
+        return r;
+    }
+    Lanes16 operator-(Lanes16 o) const {
+        Lanes16 r = { _mm256_sub_epi16(v, o.v) };
+        return r;
+    }
+    // All ones in lanes that are equal, zero elsewhere
+    Lanes16 operator==(Lanes16 o) const {
+        Lanes16 r = { _mm256_cmpeq_epi16(v, o.v) };
+        return r;
+    }
+    bool any() const {
+        return !_mm256_testz_si256(v, v);
+    }
+    // Lane k takes lane k + K; the top K lanes become zero
+    template <int K>
+    Lanes16 shift() const {
+        __m256i high = _mm256_permute2x128_si256(v, v, 0x81);
+        Lanes16 r;
+        if (K == 8)
+            r.v = high;
+        else
+            r.v = _mm256_alignr_epi8(high, v, (2 * K) & 15);
+        return r;
+    }
+};
+
+#elif defined(SUDOKU_SIMD_SSE2)
+
+struct Lanes16 {
+    __m128i lo, hi;
+
+    static Lanes16 zero() {
+        Lanes16 r = { _mm_setzero_si128(), _mm_setzero_si128() };
+        return r;
+    }
+    static Lanes16 all(lane_t x) {
+        __m128i s = _mm_set1_epi16(static_cast<short>(x));
+        Lanes16 r = { s, s };
+        return r;
+    }
+    static Lanes16 load(const lane_t * p) {
+        Lanes16 r = { _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)),
+                      _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 8)) };
+        return r;
+    }
+    void store(lane_t * p) const {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 8), hi);
+    }
+    Lanes16 operator&(Lanes16 o) const {
+        Lanes16 r = { _mm_and_si128(lo, o.lo), _mm_and_si128(hi, o.hi) };
+        return r;
+    }
+    Lanes16 operator|(Lanes16 o) const {
+        Lanes16 r = { _mm_or_si128(lo, o.lo), _mm_or_si128(hi, o.hi) };
+        return r;
+    }
+    // ~this & o
+    Lanes16 andnot(Lanes16 o) const {
+        Lanes16 r = { _mm_andnot_si128(lo, o.lo), _mm_andnot_si128(hi, o.hi) };
+        return r;
+    }
+    Lanes16 operator-(Lanes16 o) const {
+        Lanes16 r = { _mm_sub_epi16(lo, o.lo), _mm_sub_epi16(hi, o.hi) };
+        return r;
+    }
+    // All ones in lanes that are equal, zero elsewhere
+    Lanes16 operator==(Lanes16 o) const {
+        Lanes16 r = { _mm_cmpeq_epi16(lo, o.lo), _mm_cmpeq_epi16(hi, o.hi) };
+        return r;
+    }
+    bool any() const {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF;
+    }
+    // Lane k takes lane k + K; the top K lanes become zero
+    template <int K>
+    Lanes16 shift() const {
+        Lanes16 r;
+        if (K == 8) {
+            r.lo = hi;
+            r.hi = _mm_setzero_si128();
+        } else {
+            r.lo = _mm_or_si128(_mm_srli_si128(lo, (2 * K) & 15),
+                                _mm_slli_si128(hi, (16 - 2 * K) & 15));
+            r.hi = _mm_srli_si128(hi, (2 * K) & 15);
+        }
+        return r;
+    }
+};
+
+#else
+
+struct Lanes16 {
+    lane_t v[16];
+
+    static Lanes16 zero() {
+        return all(0);
+    }
+    static Lanes16 all(lane_t x) {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = x;
+        return r;
+    }
+    static Lanes16 load(const lane_t * p) {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = p[k];
+        return r;
+    }
+    void store(lane_t * p) const {
+        for (unsigned k = 0; k < 16; ++k)
+            p[k] = v[k];
+    }
+    Lanes16 operator&(Lanes16 o) const {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = v[k] & o.v[k];
+        return r;
+    }
+    Lanes16 operator|(Lanes16 o) const {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = v[k] | o.v[k];
+        return r;
+    }
+    // ~this & o
+    Lanes16 andnot(Lanes16 o) const {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = static_cast<lane_t>(~v[k] & o.v[k]);
+        return r;
+    }
+    Lanes16 operator-(Lanes16 o) const {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = static_cast<lane_t>(v[k] - o.v[k]);
+        return r;
+    }
+    // All ones in lanes that are equal, zero elsewhere
+    Lanes16 operator==(Lanes16 o) const {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = v[k] == o.v[k] ? 0xFFFF : 0;
+        return r;
+    }
+    bool any() const {
+        lane_t bits = 0;
+        for (unsigned k = 0; k < 16; ++k)
+            bits |= v[k];
+        return bits != 0;
+    }
+    // Lane k takes lane k + K; the top K lanes become zero
+    template <int K>
+    Lanes16 shift() const {
+        Lanes16 r;
+        for (unsigned k = 0; k < 16; ++k)
+            r.v[k] = k + K < 16 ? v[k + K] : 0;
+        return r;
+    }
+};
+
+#endif
+
+// Running "seen once" / "seen more than once" masks. Merging two tallies
+// is associative, so lanes can be folded together in any grouping.
+struct Tally {
+    Lanes16 once, twice;
+
+    static Tally of(Lanes16 x) {
+        Tally t = { x, Lanes16::zero() };
+        return t;
+    }
+    template <int K>
+    Tally shift() const {
+        Tally t = { once.template shift<K>(), twice.template shift<K>() };
+        return t;
+    }
+    void add(Tally o) {
+        twice = twice | o.twice | (once & o.once);
+        once = once | o.once;
+    }
+    // Bits present in exactly one of the tallied masks
+    Lanes16 single() const {
+        return twice.andnot(once);
+    }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "Dlx.hpp"
+
+// The complete solvers a caller can pick from:
+// PIPELINE runs hidden_fill, then advanced_fill, then backtrack on what is
+// left; EXTENDED is the same with every technique advanced_fill knows;
+// DANCING_LINKS hands the whole board to the exact-cover engine.
+enum engine { PIPELINE, DANCING_LINKS, EXTENDED };
+
+static inline const char * engine_name(engine e) {
+    static const char * names[] = { "pipeline", "dlx", "extended" };
+    return names[e];
+}
+
+// Places the givens of `puzzle` (81 cells, 0 for blanks) on `board`; false
+// if two of them clash
+static inline bool load_cells(const unsigned char puzzle[81], Board & board) {
+    for (unsigned k = 0; k < 81; ++k) {
+        unsigned i = k / 9, j = k % 9;
+        if (puzzle[k]) {
+            if (!board.mask_check(i, j, bitFor(puzzle[k])))
+                return false;
+            board.set(i, j, puzzle[k]);
+        }
+    }
+    return true;
+}
+
+// Completes `board` in place. Returns false if it has no solution.
+static inline bool solve_board(Board & board, engine e = PIPELINE) {
+    if (e == DANCING_LINKS) {
+        DancingLinks dlx;
+        return dlx.solve(board) != 0;
+    }
+    board.hidden_fill();
+    if (board.remaining())
+        board.advanced_fill(false, e == EXTENDED ? SWORDFISH : NAKED_PAIR);
+    if (board.remaining())
+        return board.backtrack();
+    return true;
+}
+
+#endif
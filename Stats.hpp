@@ -0,0 +1,253 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdio>
+
+#include "Bits.hpp"
+#include "Trace.hpp"
+
+// Solve statistics are compiled in unless SUDOKU_STATS is 0. A Board only
+// collects them while it has a SolveStats to report to, so the cost of an
+// unobserved solve is one null check per event.
+#ifndef SUDOKU_STATS
+#define SUDOKU_STATS 1
+#endif
+
+#if SUDOKU_STATS
+#define BOARD_STATS(event) do { if (_stats) _stats->event; } while (0)
+#define BOARD_PHASE(p) PhaseTimer phase_timer(_stats, p)
+#else
+#define BOARD_STATS(event) do { } while (0)
+#define BOARD_PHASE(p) do { } while (0)
+#endif
+
+typedef std::chrono::steady_clock StatsClock;
+
+// What one or more solves cost. Singles count placements; the other
+// techniques count eliminations, one per cell narrowed. Nodes are the cells
+// backtrack() branched on, the depth is the longest run of search
+// placements on one path, and a dead end is a branch that ran out of
+// candidates.
+struct SolveStats {
+    unsigned long long phase_ns[3];
+    unsigned long techniques[technique_count];
+    unsigned long nodes, dead_ends;
+    unsigned max_depth;
+
+    SolveStats() {
+        clear();
+    }
+    void clear() {
+        for (unsigned k = 0; k < 3; ++k)
+            phase_ns[k] = 0;
+        for (unsigned k = 0; k < technique_count; ++k)
+            techniques[k] = 0;
+        nodes = dead_ends = 0;
+        max_depth = 0;
+        _open = 0;
+    }
+    void add(const SolveStats & other) {
+        for (unsigned k = 0; k < 3; ++k)
+            phase_ns[k] += other.phase_ns[k];
+        for (unsigned k = 0; k < technique_count; ++k)
+            techniques[k] += other.techniques[k];
+        nodes += other.nodes;
+        dead_ends += other.dead_ends;
+        if (other.max_depth > max_depth)
+            max_depth = other.max_depth;
+    }
+    unsigned long long total_ns() const {
+        return phase_ns[HIDDEN_FILL] + phase_ns[ADVANCED_FILL] + phase_ns[BACKTRACK];
+    }
+
+    // Hooks for Board
+    void fired(technique t) {
+        ++techniques[t];
+    }
+    void search_begin(unsigned open) {
+        _open = open;
+    }
+    // A branch with `left` cells still open below it
+    void node(unsigned left) {
+        ++nodes;
+        if (_open - left + 1 > max_depth)
+            max_depth = _open - left + 1;
+    }
+    void dead_end() {
+        ++dead_ends;
+    }
+private:
+    unsigned _open;
+};
+
+// Adds the time from its construction to its destruction to one phase
+class PhaseTimer {
+public:
+    PhaseTimer(SolveStats * stats, phase p)
+        : _stats(stats), _phase(p) {
+        if (_stats)
+            _start = StatsClock::now();
+    }
+    ~PhaseTimer() {
+        if (_stats)
+            _stats->phase_ns[_phase] += static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(StatsClock::now() - _start).count());
+    }
+private:
+    SolveStats * _stats;
+    phase _phase;
+    StatsClock::time_point _start;
+};
+
+// A log-linear histogram: every power of two is split into eight buckets,
+// so a percentile is exact below 16 and within 12.5% above, in fixed space.
+class Histogram {
+public:
+    static const unsigned buckets = 8 * 62;
+
+    Histogram() {
+        clear();
+    }
+    void clear() {
+        for (unsigned k = 0; k < buckets; ++k)
+            _counts[k] = 0;
+        _count = 0;
+        _max = 0;
+    }
+    void record(unsigned long long value) {
+        ++_counts[_bucket(value)];
+        ++_count;
+        if (value > _max)
+            _max = value;
+    }
+    // Merges the values recorded in `other`
+    void add(const Histogram & other) {
+        for (unsigned k = 0; k < buckets; ++k)
+            _counts[k] += other._counts[k];
+        _count += other._count;
+        if (other._max > _max)
+            _max = other._max;
+    }
+    unsigned long long count() const {
+        return _count;
+    }
+    unsigned long long max() const {
+        return _max;
+    }
+    // The smallest bucket bound that at least `q` of the values fall under
+    unsigned long long percentile(double q) const {
+        if (!_count)
+            return 0;
+        unsigned long long rank = static_cast<unsigned long long>(q * _count);
+        if (rank >= _count)
+            rank = _count - 1;
+        unsigned long long seen = 0;
+        for (unsigned k = 0; k < buckets; ++k) {
+            seen += _counts[k];
+            if (seen > rank) {
+                unsigned long long bound = _upper(k);
+                return bound < _max ? bound : _max;
+            }
+        }
+        return _max;
+    }
+private:
+    unsigned long long _counts[buckets];
+    unsigned long long _count, _max;
+
+    static unsigned _bucket(unsigned long long value) {
+        if (value < 16)
+            return static_cast<unsigned>(value);
+        unsigned top = highBit(value);
+        return 8 * (top - 2) + static_cast<unsigned>((value >> (top - 3)) & 7);
+    }
+    static unsigned long long _upper(unsigned k) {
+        if (k < 16)
+            return k;
+        unsigned top = k / 8 + 2;
+        return ((8ull + k % 8 + 1) << (top - 3)) - 1;
+    }
+};
+
+// Aggregates the stats of a batch of solves, one record per puzzle, and
+// keeps the slowest puzzles by their input line so the tail can be rerun.
+class BatchStats {
+public:
+    static const unsigned slowest_kept = 10;
+
+    struct Slow {
+        unsigned long line;
+        unsigned long long ns;
+        unsigned long nodes;
+    };
+
+    BatchStats()
+        : _slow_count(0) {
+    }
+    // One solve: `ns` is its wall time, `stats` what the board reported
+    void record(unsigned long line, unsigned long long ns, const SolveStats & stats) {
+        _total.add(stats);
+        _time.record(ns);
+        _nodes.record(stats.nodes);
+        _depth.record(stats.max_depth);
+        if (_slow_count < slowest_kept)
+            ++_slow_count;
+        else if (ns <= _slow[_slow_count - 1].ns)
+            return;
+        // Insertion into the list, kept slowest first
+        unsigned k = _slow_count - 1;
+        for (; k > 0 && _slow[k - 1].ns < ns; --k)
+            _slow[k] = _slow[k - 1];
+        _slow[k].line = line;
+        _slow[k].ns = ns;
+        _slow[k].nodes = stats.nodes;
+    }
+    const SolveStats & totals() const {
+        return _total;
+    }
+    const Histogram & times() const {
+        return _time;
+    }
+    const Histogram & nodes() const {
+        return _nodes;
+    }
+    void report(std::FILE * out) const {
+        unsigned long long puzzles = _time.count();
+        std::fprintf(out, "stats: %llu puzzle(s)\n", puzzles);
+        if (!puzzles)
+            return;
+        unsigned long long phases = _total.total_ns();
+        for (unsigned p = HIDDEN_FILL; p <= BACKTRACK; ++p)
+            std::fprintf(out, "  %-14s %10.3f ms  %5.1f%%\n", phase_name(static_cast<phase>(p)),
+                         _total.phase_ns[p] / 1e6,
+                         phases ? 100.0 * _total.phase_ns[p] / phases : 0.0);
+        for (unsigned t = NAKED_SINGLE; t < technique_count; ++t)
+            std::fprintf(out, "  %-14s %10lu\n", technique_name(static_cast<technique>(t)),
+                         _total.techniques[t]);
+        std::fprintf(out, "  search: %lu node(s), %lu dead end(s), max depth %u\n",
+                     _total.nodes, _total.dead_ends, _total.max_depth);
+        std::fprintf(out, "  %-14s %10s %10s %10s %10s %10s\n", "per puzzle", "p50", "p90", "p99",
+                     "p99.9", "max");
+        _row(out, "time (us)", _time, 1e-3);
+        _row(out, "nodes", _nodes, 1);
+        _row(out, "depth", _depth, 1);
+        std::fprintf(out, "  slowest:\n");
+        for (unsigned k = 0; k < _slow_count; ++k)
+            std::fprintf(out, "    line %lu: %.1f us, %lu node(s)\n", _slow[k].line,
+                         _slow[k].ns / 1e3, _slow[k].nodes);
+    }
+private:
+    SolveStats _total;
+    Histogram _time, _nodes, _depth;
+    Slow _slow[slowest_kept];
+    unsigned _slow_count;
+
+    static void _row(std::FILE * out, const char * name, const Histogram & h, double scale) {
+        std::fprintf(out, "  %-14s %10.1f %10.1f %10.1f %10.1f %10.1f\n", name,
+                     h.percentile(0.5) * scale, h.percentile(0.9) * scale,
+                     h.percentile(0.99) * scale, h.percentile(0.999) * scale, h.max() * scale);
+    }
+};
+
+#endif
@@ -1,159 +1,61 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
-#include <ctime>
 #include <algorithm>
+#include <cstring>
+#include <random>
 
-std::ofstream output("Sudoku.log");
+#include "Board.hpp"
+#include "Batch.hpp"
+#include "Generator.hpp"
+#include "Hints.hpp"
+#ifdef __linux__
+#include "Server.hpp"
+#endif
 
-typedef unsigned bitfield;
+// Debug builds keep a step-by-step trace of every solve in Sudoku.log
+#if SUDOKU_TRACE
+static std::ofstream output("Sudoku.log");
+static StreamTrace log_trace(output);
+static TraceSink * const solve_trace = &log_trace;
+#else
+static TraceSink * const solve_trace = 0;
+#endif
 
-static const bitfield maskMax = 512;
-static const bitfield allSet = 511;
-
-enum difficulty { DEFAULT, EASY, MEDIUM, DIFFICULT, EVIL };
-
-// Returns the size of the set
-static unsigned bitCount(bitfield bits) {
-    unsigned result = 0;
-    bitfield mask = 1;
-
-    while(mask != maskMax) {
-        if (bits & mask)
-            result++;
-        mask *= 2;
-    }
-
-    return result;
+static inline void trace_note(const char * what) {
+#if SUDOKU_TRACE
+    log_trace.note(what);
+#else
+    (void)what;
+#endif
 }
 
-// Returns a bitfield representing {num}
-static inline bitfield bitFor(unsigned num) {
-    return 1 << (num - 1);
+static inline void clear_screen() {
+#ifdef _WIN32
+    std::system("cls");
+#else
+    std::cout << "\033[2J\033[H" << std::flush;
+#endif
 }
 
-#include "Board.h"
-
-class Holes {
-public:
-    Holes(Board & board)
-        : puzzle(board) {
-    }
-    void digHoles(difficulty level) {
-        static unsigned look_up[] = {
-            0,  1,  2,
-            9,  10, 11,
-            18, 19, 20
-        };
-        static unsigned base[] = {
-            0,  3,  6,
-            27, 30, 33,
-            54, 57, 60
-        };
-        static unsigned array[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
-        for (unsigned i = 0; i < 9; ++i) {
-            unsigned diff = _level_min(level);
-            std::random_shuffle(array, array + 9);
-            for (unsigned j = 0; j < diff; ++j) {
-                unsigned loc = base[(4 * i) % 9] + look_up[array[j]];
-                unsigned row = loc / 9, col = loc % 9;
-                _valid_dig(row, col, level);
-            }
-        }
-
-        unsigned control = 81;
-        if (level == MEDIUM) {
-            control = 45;
-        } else if (level == DIFFICULT) {
-            control = 65;
-        } else if (level == EVIL) {
-            control = 105;
-        } else if (level == DEFAULT) {
-            control = 300;
-        }
-        for (unsigned k = 0; k < control; ++k) {
-            unsigned loc = std::rand() % 81;
-            unsigned row = loc / 9, col = loc % 9;
-            if (!puzzle.assert(row, col, 0)) {
-                _valid_dig(row, col, level);
-            }
-        }
-    }
-    Board& to_play() {
-        return puzzle;
-    }
-private:
-    Board puzzle;
-
-    unsigned _level_min(difficulty level) {
-        unsigned limit;
-        unsigned rand = std::rand() % 4;
-
-        switch (level) {
-        case EASY:
-            limit = 2;
-            break;
-        case MEDIUM:
-            limit = 2;
-            break;
-        case DIFFICULT:
-            limit = 4 + rand;
-            break;
-        case EVIL:
-            limit = 6 + rand;
-            break;
-        default:
-            limit = 0;
-        }
-        return limit;
-    }
-
-    void _valid_dig(unsigned i, unsigned j, difficulty level) {
-        unsigned val = puzzle.unset(i, j);
-        if (level == EASY) {
-            Board bd = puzzle;
-            bd.hidden_fill();
-            if (bd.remaining()) {
-                puzzle.set(i, j, val);
-                return;
-            }
-        } else {
-            for (unsigned num = 1; num <= 9; ++num) {
-                if (num != val &&
-                        puzzle.mask_check(i, j, bitFor(num))) {
-                    Board bd = puzzle;
-                    bd.set(i, j, num);
-                    bd.hidden_fill();
-                    bd.advanced_fill();
-                    if (bd.backtrack()) {
-                        puzzle.set(i, j, val);
-                        return;
-                    }
-                }
-            }
-        }
-    }
-};
-
 class Sudoku {
 public:
     bool unique_solution;
+    // Whether the file held a well-formed puzzle
+    bool imported;
+    // What solving the imported puzzle cost
+    SolveStats stats;
 
     Sudoku(const char * name) {
-        std::ifstream in(name);
-        unsigned num = 0;
-        for (unsigned i = 0; i < 9; ++i) {
-            for (unsigned j = 0; j < 9; ++j) {
-                in >> num;
-                _board.set(i, j, num);
-            }
-        }
+        _board.trace_to(solve_trace);
+        unique_solution = false;
+        imported = _import(name);
+        if (!imported)
+            return;
         _board.print_board(std::cout);
         _answer = _board;
-        unique_solution = false;
         if (_has_solution()) {
-            unsigned solutions = _answer.solution_count();
-            if (solutions == 1) {
+            if (_solutions == 1) {
                 unique_solution = true;
             } else {
                 std::cout << "Multiple solutions!" << std::endl;
@@ -165,33 +67,24 @@ public:
         }
     }
     Sudoku(difficulty level, std::ostream & out) {
-        output << "Generating new puzzle:" << std::endl;
+        trace_note("Generating new puzzle");
         generate(level, out);
     }
     void generate(difficulty level, std::ostream & out) {
-        _answer = Board(static_cast<unsigned>(std::time(0)));
-        while (true) {
-            Holes game(_answer);
-            game.digHoles(level);
-            Board bd = game.to_play();
-            if (level > EASY) {
-                bd.hidden_fill();
-                if (!bd.remaining())
-                    continue;
-                bd.advanced_fill();
-                if (level > MEDIUM && !bd.remaining())
-                    continue;
-            }
-            _board = game.to_play();
-            break;
-        }
+        std::random_device entropy;
+        Random rng(static_cast<std::uint64_t>(entropy()) << 32 | entropy());
+        generate_puzzle(level, rng, _board, _answer);
+        _board.trace_to(solve_trace);
+        _answer.trace_to(solve_trace);
         _board.print_board(out);
     }
     void play(unsigned& row, unsigned& col, unsigned& val) {
         if (_board.mask_check(row, col, bitFor(val)))
             if (_answer.assert(row, col, val)) {
                 _board.set(row, col, val);
-                system("cls");
+                if (_hints.started())
+                    _hints.play(row, col, val);
+                clear_screen();
                 _board.print_board(std::cout);
             } else
                 std::cout << "You've chosen the wrong number.\n";
@@ -201,14 +94,10 @@ public:
     bool is_complete() {
         return _board.remaining() == 0;
     }
-    void solve(bool verbose = true) {
+    void solve(bool verbose = true, engine e = PIPELINE) {
         _answer = _board;
-        output << "\nSolving puzzle:";
-        _answer.hidden_fill();
-        if (_answer.remaining())
-            _answer.advanced_fill();
-        if (_answer.remaining())
-            _answer.backtrack();
+        trace_note("Solving puzzle");
+        solve_board(_answer, e);
         if (verbose) {
             std::cout << "The answer is:" << std::endl;
             _answer.print_board(std::cout);
@@ -216,57 +105,346 @@ public:
     }
     void partial_solve() {
         _answer = _board;
-        output << "\nSolving puzzle:";
+        trace_note("Solving puzzle");
         _answer.hidden_fill();
         if (_answer.remaining())
-            _answer.advanced_fill();
+            _answer.advanced_fill(false, SWORDFISH);
         std::cout << "Logic solver gives:" << std::endl;
         _answer.print_board(std::cout);
         std::cout << _answer.remaining() << " cell(s) are left blank." << std::endl;
     }
     void next_step() {
-        Board ans = _board;
-        output << "\n\nFetching a hint:";
-        unsigned hint;
-        if (ans.hidden_fill(true)) {
-            hint = ans.one_step;
-            unsigned row = hint / 9, col = hint % 9;
-            std::cout << "SINGLE(NAKED SINGLE, HIDDGE SINGLE, FULL HOUSE): "
-                      << 'R' << row + 1 << 'C' << col + 1 << '='
-                      << ans.get_num(row, col) << std::endl;
-        } else if (ans.advanced_fill(true)) {
-            hint = ans.one_step;
-            unsigned row = hint / 9, col = hint % 9;
-            std::cout << "LOCKED CANDIDATE AND PAIR CHECK(2-(2+) ONLY): "
-                      << 'R' << row + 1 << 'C' << col + 1 << '='
-                      << ans.get_num(row, col) << std::endl;
-        } else {
-            std::srand(static_cast<unsigned>(std::time(0)));
-            do {
-                hint = std::rand() % 81;
-            } while (!ans.assert(hint / 9, hint % 9, 0));
-            unsigned row = hint / 9, col = hint % 9;
-            std::cout << "RANDOM HINT: "
-                      << 'R' << row + 1 << 'C' << col + 1 << '='
-                      << _answer.get_num(row, col) << std::endl;
+        trace_note("Fetching a hint");
+        if (!_hints.started())
+            _hints.start(_board, _answer);
+        Hint hint;
+        if (_hints.next(hint)) {
+            std::cout << "HINT: ";
+            hint.print(std::cout);
+            std::cout << std::endl;
         }
     }
 private:
     Board _board;
     Board _answer;
+    unsigned _solutions;
+    // Started by the first hint, then kept in step with every move
+    HintEngine _hints;
 
+    // Reads the first puzzle in the file, as one line or a 9x9 grid, onto
+    // _board. Says what is wrong and returns false if it cannot.
+    bool _import(const char * name) {
+        std::FILE * in = std::fopen(name, "rb");
+        if (!in) {
+            std::cout << "Cannot open " << name << std::endl;
+            return false;
+        }
+        std::unique_ptr<LineReader> reader(new LineReader(in));
+        PuzzleParser parser;
+        unsigned char cells[81];
+        const char * line;
+        unsigned length;
+        PuzzleParser::status status = PuzzleParser::MORE;
+        while (status == PuzzleParser::MORE && reader->next(line, length))
+            status = parser.feed(line, length, reader->line_number(), cells);
+        if (status == PuzzleParser::MORE)
+            status = parser.finish(reader->line_number());
+        std::fclose(in);
+        if (status != PuzzleParser::PUZZLE) {
+            const ParseError & error = parser.error();
+            if (error.message)
+                std::cout << name << ":" << error.line << ": " << error.message << std::endl;
+            else
+                std::cout << name << ": no puzzle" << std::endl;
+            return false;
+        }
+        for (unsigned k = 0; k < 81; ++k) {
+            if (!cells[k])
+                continue;
+            if (!_board.mask_check(k / 9, k % 9, bitFor(cells[k]))) {
+                std::cout << name << ": the " << cells[k] + 0 << " at row " << k / 9 + 1
+                          << ", column " << k % 9 + 1 << " clashes with another given"
+                          << std::endl;
+                return false;
+            }
+            _board.set(k / 9, k % 9, cells[k]);
+        }
+        return true;
+    }
+    // Counts solutions up to two and, if there is one, leaves it in _answer
     bool _has_solution() {
-        output << "\nChecking solutions:";
-        _answer.hidden_fill();
-        _answer.advanced_fill();
-        if (_answer.backtrack(true))
-            return true;
-        else
+        trace_note("Checking solutions");
+        _solutions = _board.count_solutions(2);
+        if (!_solutions)
             return false;
+        _answer = _board;
+        _answer.stats_to(&stats);
+        solve_board(_answer);
+        _answer.stats_to(0);
+        return true;
     }
 };
 
-int main() {
+static bool parse_engine(const char * name, engine & e) {
+    for (unsigned k = PIPELINE; k <= EXTENDED; ++k)
+        if (std::strcmp(name, engine_name(static_cast<engine>(k))) == 0) {
+            e = static_cast<engine>(k);
+            return true;
+        }
+    return false;
+}
+
+// Batch mode: Sudoku -b [-j threads] [-e pipeline|extended|dlx] [-l] [-s]
+//                       [-c entries] [file]
+// Reads puzzles, one line or a 9x9 grid each, from the file (or stdin when
+// it is omitted or "-"), or every record of a file packed with -p, and
+// writes one solution per line to stdout. Puzzles are spread over
+// all cores unless -j says otherwise; -e picks the solving engine. -s
+// reports solver stats and per-puzzle percentiles on stderr. -c answers
+// puzzles equivalent to recent ones from a cache of that many entries.
+static int batch(int argc, char * argv[]) {
+    const char * name = 0;
+    unsigned threads = ThreadPool::default_threads();
+    engine e = PIPELINE;
+    bool lockstep = false, stats = false;
+    std::size_t cache_size = 0;
+    for (int k = 2; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-j") == 0 && k + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++k]));
+        } else if (std::strcmp(argv[k], "-e") == 0 && k + 1 < argc) {
+            if (!parse_engine(argv[++k], e)) {
+                std::fprintf(stderr, "Unknown engine %s\n", argv[k]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[k], "-l") == 0) {
+            lockstep = true;
+        } else if (std::strcmp(argv[k], "-s") == 0) {
+            stats = true;
+        } else if (std::strcmp(argv[k], "-c") == 0 && k + 1 < argc) {
+            cache_size = std::strtoul(argv[++k], 0, 10);
+        } else {
+            name = argv[k];
+        }
+    }
+    std::FILE * in = stdin;
+    if (name && std::strcmp(name, "-") != 0) {
+        in = std::fopen(name, "rb");
+        if (!in) {
+            std::fprintf(stderr, "Cannot open %s\n", name);
+            return 1;
+        }
+    }
+    ArchiveReader archive;
+    bool packed = in != stdin && is_archive(in);
+    if (packed && !archive.open(name)) {
+        std::fprintf(stderr, "%s: %s\n", name, archive.error());
+        std::fclose(in);
+        return 1;
+    }
+    std::unique_ptr<BatchStats> report(stats ? new BatchStats : 0);
+    std::unique_ptr<PuzzleCache> cache(cache_size ? new PuzzleCache(cache_size) : 0);
+    BatchSolver solver(in, stdout, stderr, threads, e, lockstep, report.get(), cache.get());
+    if (packed)
+        solver.read_from(&archive);
+    solver.run();
+    if (archive.position() < archive.count()) {
+        std::fprintf(stderr, "record %llu: %s\n", archive.position() + 1, archive.error());
+        ++solver.failed;
+    }
+    if (report)
+        report->report(stderr);
+    else if (cache)
+        std::fprintf(stderr, "cache: %lu hit(s), %lu miss(es)\n", cache->hits(), cache->misses());
+    if (in != stdin)
+        std::fclose(in);
+    return solver.failed ? 2 : 0;
+}
+
+// Pack mode: Sudoku -p [-a solutions] [-o archive] [puzzles]
+// Packs one-line puzzles (stdin when the file is omitted or "-") into an
+// archive (see Archive.hpp) on stdout or the -o file. -a adds the
+// solutions in a file -b wrote for the same puzzles.
+static int pack(int argc, char * argv[]) {
+    const char * names[3] = { 0, 0, 0 };
+    for (int k = 2; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-a") == 0 && k + 1 < argc)
+            names[1] = argv[++k];
+        else if (std::strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+            names[2] = argv[++k];
+        else
+            names[0] = argv[k];
+    }
+    std::FILE * files[3] = { stdin, 0, stdout };
+    const char * modes[3] = { "rb", "rb", "wb" };
+    for (unsigned k = 0; k < 3; ++k) {
+        if (!names[k] || std::strcmp(names[k], "-") == 0)
+            continue;
+        files[k] = std::fopen(names[k], modes[k]);
+        if (!files[k]) {
+            std::fprintf(stderr, "Cannot open %s\n", names[k]);
+            return 1;
+        }
+    }
+    unsigned long long count = pack_text(files[0], files[1], files[2], stderr);
+    std::fprintf(stderr, "packed %llu puzzle(s)\n", count);
+    for (unsigned k = 0; k < 3; ++k)
+        if (files[k] && files[k] != stdin && files[k] != stdout)
+            std::fclose(files[k]);
+    return 0;
+}
+
+// Unpack mode: Sudoku -u [-a solutions] archive
+// Writes the archive's puzzles as one-line text to stdout and, with -a,
+// its solutions to that file, an empty line where a puzzle has none.
+static int unpack(int argc, char * argv[]) {
+    const char * name = 0, * solutions = 0;
+    for (int k = 2; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-a") == 0 && k + 1 < argc)
+            solutions = argv[++k];
+        else
+            name = argv[k];
+    }
+    ArchiveReader archive;
+    if (!name || !archive.open(name)) {
+        std::fprintf(stderr, "%s: %s\n", name ? name : "Sudoku -u", archive.error());
+        return 1;
+    }
+    std::FILE * out = 0;
+    if (solutions && !(out = std::fopen(solutions, "wb"))) {
+        std::fprintf(stderr, "Cannot open %s\n", solutions);
+        return 1;
+    }
+    bool intact = unpack_text(archive, stdout, out);
+    if (out)
+        std::fclose(out);
+    if (!intact) {
+        std::fprintf(stderr, "record %llu: %s\n", archive.position() + 1, archive.error());
+        return 2;
+    }
+    return 0;
+}
+
+#ifdef __linux__
+// Server mode: Sudoku -S [-j threads] [-e pipeline|extended|dlx]
+//                        [-p port | -u socket]
+// Answers the line protocol of SolverService (see Server.hpp) on
+// 127.0.0.1:port (9081 by default; 0 picks a free one) or on a Unix socket
+// until interrupted. Requests are solved on all cores unless -j says
+// otherwise; -e picks the engine for solve requests.
+static int serve(int argc, char * argv[]) {
+    unsigned threads = ThreadPool::default_threads();
+    unsigned port = 9081;
+    const char * path = 0;
+    engine e = PIPELINE;
+    for (int k = 2; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-j") == 0 && k + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++k]));
+        } else if (std::strcmp(argv[k], "-e") == 0 && k + 1 < argc) {
+            if (!parse_engine(argv[++k], e)) {
+                std::fprintf(stderr, "Unknown engine %s\n", argv[k]);
+                return 1;
+            }
+        } else if (std::strcmp(argv[k], "-p") == 0 && k + 1 < argc) {
+            port = static_cast<unsigned>(std::atoi(argv[++k]));
+        } else if (std::strcmp(argv[k], "-u") == 0 && k + 1 < argc) {
+            path = argv[++k];
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[k]);
+            return 1;
+        }
+    }
+    std::random_device entropy;
+    SolverService service(static_cast<std::uint64_t>(entropy()) << 32 | entropy(), e);
+    SolverServer server(service, threads);
+    if (!(path ? server.listen_unix(path) : server.listen_tcp(port))) {
+        std::fprintf(stderr, "%s: %s\n", path ? path : "127.0.0.1", server.error());
+        return 1;
+    }
+    if (path)
+        std::fprintf(stderr, "listening on %s\n", path);
+    else
+        std::fprintf(stderr, "listening on 127.0.0.1:%u\n", server.port());
+    if (!server.run()) {
+        std::fprintf(stderr, "%s\n", server.error());
+        return 1;
+    }
+    std::fprintf(stderr, "served %lu request(s)\n", server.served);
+    return 0;
+}
+#endif
+
+static bool parse_level(const char * name, difficulty & level) {
+    for (unsigned k = EASY; k <= EVIL; ++k)
+        if (std::strcmp(name, difficulty_name(static_cast<difficulty>(k))) == 0) {
+            level = static_cast<difficulty>(k);
+            return true;
+        }
+    return false;
+}
+
+// Generator mode: Sudoku -g [-j threads] [-n count] [-s seed] [-i first]
+//                           [-l easy|medium|difficult|evil]...
+// Writes `count` puzzles (default 1) of each chosen level (default all
+// four) to stdout, one per line, after a '#' line naming the level, the
+// seed and the index range. Puzzle i of a level depends only on the seed,
+// the level and i, so `-s seed -i i -n 1` regenerates it exactly.
+static int generate(int argc, char * argv[]) {
+    unsigned threads = ThreadPool::default_threads();
+    unsigned long count = 1, first = 0;
+    std::uint64_t seed = std::random_device()();
+    difficulty levels[4];
+    unsigned level_count = 0;
+    for (int k = 2; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-j") == 0 && k + 1 < argc) {
+            threads = static_cast<unsigned>(std::atoi(argv[++k]));
+        } else if (std::strcmp(argv[k], "-n") == 0 && k + 1 < argc) {
+            count = std::strtoul(argv[++k], 0, 10);
+        } else if (std::strcmp(argv[k], "-i") == 0 && k + 1 < argc) {
+            first = std::strtoul(argv[++k], 0, 10);
+        } else if (std::strcmp(argv[k], "-s") == 0 && k + 1 < argc) {
+            seed = std::strtoull(argv[++k], 0, 10);
+        } else if (std::strcmp(argv[k], "-l") == 0 && k + 1 < argc && level_count < 4) {
+            if (!parse_level(argv[++k], levels[level_count++])) {
+                std::fprintf(stderr, "Unknown level %s\n", argv[k]);
+                return 1;
+            }
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[k]);
+            return 1;
+        }
+    }
+    if (!level_count)
+        for (unsigned k = EASY; k <= EVIL; ++k)
+            levels[level_count++] = static_cast<difficulty>(k);
+
+    BatchGenerator generator(stdout, seed, threads);
+    for (unsigned k = 0; k < level_count; ++k) {
+        std::printf("# %s, seed %llu, puzzles %lu-%lu\n", difficulty_name(levels[k]),
+                    static_cast<unsigned long long>(seed), first, first + count - 1);
+        std::fflush(stdout);
+        generator.run(levels[k], first, count);
+    }
+    return 0;
+}
+
+int main(int argc, char * argv[]) {
+    if (argc > 1 && (std::strcmp(argv[1], "-b") == 0 ||
+                     std::strcmp(argv[1], "--batch") == 0))
+        return batch(argc, argv);
+    if (argc > 1 && (std::strcmp(argv[1], "-g") == 0 ||
+                     std::strcmp(argv[1], "--generate") == 0))
+        return generate(argc, argv);
+    if (argc > 1 && (std::strcmp(argv[1], "-p") == 0 ||
+                     std::strcmp(argv[1], "--pack") == 0))
+        return pack(argc, argv);
+    if (argc > 1 && (std::strcmp(argv[1], "-u") == 0 ||
+                     std::strcmp(argv[1], "--unpack") == 0))
+        return unpack(argc, argv);
+#ifdef __linux__
+    if (argc > 1 && (std::strcmp(argv[1], "-S") == 0 ||
+                     std::strcmp(argv[1], "--serve") == 0))
+        return serve(argc, argv);
+#endif
 BG:
     char mode = 0;
     std::cout << "Import puzzle file (I) or Generate one (G): ";
@@ -275,10 +453,11 @@ BG:
         char file[100];
         std::cout << "Please specify the file: ";
         std::cin >> file;
-        system("cls");
-        clock_t b = clock();
+        clear_screen();
         Sudoku puzzle(file);
-        std::cout << clock() - b << std::endl;
+        if (puzzle.imported)
+            std::cout << "Solved in " << puzzle.stats.total_ns() / 1e3 << " us, "
+                      << puzzle.stats.nodes << " search node(s)" << std::endl;
         if (puzzle.unique_solution) {
 CPM:
             std::cout << "Solve it Completely (C) or Partially (P) or Manually (M): ";
@@ -340,7 +519,7 @@ SP:
             Sudoku puzzle(level, ofs);
             std::cout << "Saved as Sudoku.out" << std::endl;
         } else if (mode == 'P' || mode == 'p') {
-            system("cls");
+            clear_screen();
             Sudoku puzzle(level, std::cout);
             puzzle.solve(false);
             unsigned row, col, val;
@@ -364,7 +543,7 @@ SP:
     std::cout << "Quit(Q) or Run Again(R)?" << std::endl;
     std::cin >> mode;
     if (mode == 'R' || mode == 'r') {
-        system("cls");
+        clear_screen();
         goto BG;
     }
 }
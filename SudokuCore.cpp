@@ -0,0 +1,80 @@
+#include "SudokuCore.hpp"
+
+#include "Batch.hpp"
+#include "Generator.hpp"
+#include "Hints.hpp"
+
+static_assert(SUDOKU_PIPELINE == static_cast<int>(PIPELINE) &&
+              SUDOKU_DANCING_LINKS == static_cast<int>(DANCING_LINKS) &&
+              SUDOKU_EXTENDED == static_cast<int>(EXTENDED),
+              "SudokuEngine must number the engines as Solver.hpp does");
+static_assert(SUDOKU_DEFAULT == static_cast<int>(DEFAULT) &&
+              SUDOKU_EASY == static_cast<int>(EASY) &&
+              SUDOKU_MEDIUM == static_cast<int>(MEDIUM) &&
+              SUDOKU_DIFFICULT == static_cast<int>(DIFFICULT) &&
+              SUDOKU_EVIL == static_cast<int>(EVIL),
+              "SudokuLevel must number the levels as Holes.hpp does");
+static_assert(SudokuHint::text_capacity > Hint::text_capacity,
+              "SudokuHint must hold any hint text and a terminator");
+
+static void store_cells(Board & board, unsigned char cells[81]) {
+    for (unsigned k = 0; k < 81; ++k)
+        cells[k] = static_cast<unsigned char>(board.get_num(k / 9, k % 9));
+}
+
+bool sudoku_solve(const unsigned char puzzle[81], unsigned char answer[81], SudokuEngine e) {
+    return solve_cells(puzzle, answer, static_cast<engine>(e));
+}
+
+unsigned sudoku_count_solutions(const unsigned char puzzle[81], unsigned limit) {
+    Board board;
+    if (!load_cells(puzzle, board))
+        return 0;
+    return board.count_solutions(limit);
+}
+
+bool sudoku_rate(const unsigned char puzzle[81], SudokuRating & rating) {
+    Board board;
+    if (!load_cells(puzzle, board))
+        return false;
+    Rating found = rate_in_place(board);
+    rating.level = static_cast<SudokuLevel>(found.level());
+    rating.singles = found.singles;
+    rating.advanced = found.advanced;
+    rating.search = found.search;
+    return true;
+}
+
+bool sudoku_hint(const unsigned char puzzle[81], SudokuHint & hint) {
+    Board board;
+    if (!load_cells(puzzle, board) || board.count_solutions(2) != 1)
+        return false;
+    Board answer = board;
+    solve_board(answer);
+    HintEngine hints;
+    hints.start(board, answer);
+    Hint found;
+    if (!hints.next(found))
+        return false;
+    hint.row = found.row;
+    hint.col = found.col;
+    hint.val = found.val;
+    hint.text[found.format(hint.text)] = '\0';
+    return true;
+}
+
+void sudoku_generate(SudokuLevel level, std::uint64_t seed, unsigned long index,
+                     unsigned char puzzle[81], unsigned char answer[81]) {
+    Random rng = puzzle_random(seed, static_cast<difficulty>(level), index);
+    Board dug, solution;
+    generate_puzzle(static_cast<difficulty>(level), rng, dug, solution);
+    store_cells(dug, puzzle);
+    store_cells(solution, answer);
+}
+
+unsigned long sudoku_solve_stream(std::FILE * in, std::FILE * out, std::FILE * err,
+                                  unsigned threads, SudokuEngine e) {
+    BatchSolver solver(in, out, err, threads, static_cast<engine>(e));
+    solver.run();
+    return solver.failed;
+}
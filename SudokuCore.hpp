@@ -0,0 +1,63 @@
+#ifndef SUDOKU_CORE_H
+#define SUDOKU_CORE_H
+
+#include <cstdint>
+#include <cstdio>
+
+// The engine's entry points, compiled once into the sudoku_core library so
+// a program can link them instead of instantiating the engine itself. This
+// header stands alone: it declares plain types of its own and none of the
+// engine's, whose layout depends on build flags. The engine headers stay
+// usable directly for finer control, built with the SUDOKU_TRACE and
+// SUDOKU_STATS values sudoku_core exports. Puzzles are 81 cells in row
+// order, 0 for blanks.
+
+// The solvers, numbered as Solver.hpp's engine
+enum SudokuEngine { SUDOKU_PIPELINE, SUDOKU_DANCING_LINKS, SUDOKU_EXTENDED };
+
+// Puzzle levels, numbered as Holes.hpp's difficulty
+enum SudokuLevel { SUDOKU_DEFAULT, SUDOKU_EASY, SUDOKU_MEDIUM, SUDOKU_DIFFICULT, SUDOKU_EVIL };
+
+// How a puzzle is solved by logic; see Rating
+struct SudokuRating {
+    SudokuLevel level;
+    unsigned singles, advanced, search;
+};
+
+// The next step toward the solution, as the interactive mode hints it
+struct SudokuHint {
+    // Room for the longest hint text and its terminator
+    static const unsigned text_capacity = 257;
+
+    unsigned row, col, val;
+    // Like "R8C3=1 by hidden single", with a terminator
+    char text[text_capacity];
+};
+
+// Solves `puzzle` into `answer`, which may be the same array. Returns false
+// if the givens clash or the puzzle has no solution.
+bool sudoku_solve(const unsigned char puzzle[81], unsigned char answer[81],
+                  SudokuEngine e = SUDOKU_PIPELINE);
+
+// The number of solutions, counting stops at `limit`; 0 if the givens clash
+unsigned sudoku_count_solutions(const unsigned char puzzle[81], unsigned limit = 2);
+
+// What solving `puzzle` by logic takes; see rate_puzzle. Returns false,
+// leaving `rating` alone, if the givens clash.
+bool sudoku_rate(const unsigned char puzzle[81], SudokuRating & rating);
+
+// The hint the interactive mode would give first for `puzzle`. Returns
+// false if it has no unique solution or is already complete.
+bool sudoku_hint(const unsigned char puzzle[81], SudokuHint & hint);
+
+// Puzzle `index` of `level` in a run seeded with `seed`, the same puzzle
+// `Sudoku -g -s seed -i index` prints, and its solution
+void sudoku_generate(SudokuLevel level, std::uint64_t seed, unsigned long index,
+                     unsigned char puzzle[81], unsigned char answer[81]);
+
+// Solves puzzles from `in` into `out` as `Sudoku -b` does. Returns the
+// number of puzzles that were malformed or had no solution.
+unsigned long sudoku_solve_stream(std::FILE * in, std::FILE * out, std::FILE * err,
+                                  unsigned threads = 1, SudokuEngine e = SUDOKU_PIPELINE);
+
+#endif
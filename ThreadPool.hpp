@@ -0,0 +1,102 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of workers, each with its own task queue. A worker takes the
+// oldest task from its own queue and, when that runs dry, steals the newest
+// task from another worker's queue.
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    explicit ThreadPool(unsigned threads)
+        : _queues(threads ? threads : 1), _next(0), _pending(0), _stop(false) {
+        for (unsigned k = 0; k < _queues.size(); ++k)
+            _threads.push_back(std::thread(&ThreadPool::_work, this, k));
+    }
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(_idle_lock);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (unsigned k = 0; k < _threads.size(); ++k)
+            _threads[k].join();
+    }
+    void submit(const Task & task) {
+        Queue & queue = _queues[_next++ % _queues.size()];
+        // Counted before it is queued, so a worker that takes it at once
+        // never brings _pending below zero
+        {
+            std::lock_guard<std::mutex> guard(_idle_lock);
+            ++_pending;
+        }
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.tasks.push_back(task);
+        }
+        _wake.notify_one();
+    }
+    unsigned size() {
+        return static_cast<unsigned>(_queues.size());
+    }
+
+    static unsigned default_threads() {
+        unsigned n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<Queue> _queues;
+    std::vector<std::thread> _threads;
+    std::atomic<unsigned> _next;
+    std::atomic<unsigned> _pending;
+    std::mutex _idle_lock;
+    std::condition_variable _wake;
+    bool _stop;
+
+    bool _take(unsigned self, Task & task) {
+        for (unsigned k = 0; k < _queues.size(); ++k) {
+            Queue & queue = _queues[(self + k) % _queues.size()];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if (queue.tasks.empty())
+                continue;
+            if (k == 0) {
+                task.swap(queue.tasks.front());
+                queue.tasks.pop_front();
+            } else {
+                task.swap(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            --_pending;
+            return true;
+        }
+        return false;
+    }
+    void _work(unsigned self) {
+        Task task;
+        while (true) {
+            if (_take(self, task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> guard(_idle_lock);
+            _wake.wait(guard, [this] { return _pending > 0 || _stop; });
+            if (_stop && _pending == 0)
+                return;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <ostream>
+
+#include "Bits.hpp"
+
+// Solve tracing is compiled in only when SUDOKU_TRACE is non-zero, which is
+// the default for builds without NDEBUG. Otherwise every trace point in
+// Board expands to nothing.
+#ifndef SUDOKU_TRACE
+#ifdef NDEBUG
+#define SUDOKU_TRACE 0
+#else
+#define SUDOKU_TRACE 1
+#endif
+#endif
+
+#if SUDOKU_TRACE
+#define BOARD_TRACE(event) do { if (_trace) _trace->event; } while (0)
+#else
+#define BOARD_TRACE(event) do { } while (0)
+#endif
+
+enum phase { HIDDEN_FILL, ADVANCED_FILL, BACKTRACK };
+
+enum technique {
+    NAKED_SINGLE, HIDDEN_SINGLE, LOCKED_SET, POINTING, CLAIMING, NAKED_PAIR,
+    HIDDEN_PAIR, NAKED_TRIPLE, HIDDEN_TRIPLE, X_WING, NAKED_QUAD, XY_WING, SWORDFISH
+};
+
+static const unsigned technique_count = SWORDFISH + 1;
+
+static inline const char * phase_name(phase p) {
+    static const char * names[] = { "hidden_fill", "advanced_fill", "backtrack" };
+    return names[p];
+}
+
+static inline const char * technique_name(technique t) {
+    static const char * names[] = {
+        "naked single", "hidden single", "locked set", "pointing", "claiming",
+        "naked pair", "hidden pair", "naked triple", "hidden triple", "x-wing",
+        "naked quad", "xy-wing", "swordfish"
+    };
+    return names[t];
+}
+
+// Receives one event per solving step. Cells are numbered 9 * row + col.
+class TraceSink {
+public:
+    virtual ~TraceSink() {
+    }
+    virtual void note(const char * what) = 0;
+    virtual void pass(phase p) = 0;
+    virtual void placed(technique t, unsigned cell, unsigned num) = 0;
+    virtual void eliminated(technique t, unsigned cell, bitfield digits) = 0;
+    virtual void searched(unsigned attempts, bool solved) = 0;
+};
+
+// Writes the trace as one line per event. Nothing is flushed on purpose.
+class StreamTrace : public TraceSink {
+public:
+    StreamTrace(std::ostream & out)
+        : _out(out) {
+    }
+    void note(const char * what) {
+        _out << what << '\n';
+    }
+    void pass(phase p) {
+        _out << phase_name(p) << " pass\n";
+    }
+    void placed(technique t, unsigned cell, unsigned num) {
+        _out << "  " << technique_name(t) << ": ";
+        _cell(cell);
+        _out << '=' << num << '\n';
+    }
+    void eliminated(technique t, unsigned cell, bitfield digits) {
+        _out << "  " << technique_name(t) << ": ";
+        _cell(cell);
+        _out << "-{";
+        for (unsigned num = 1; num <= 9; ++num)
+            if (digits & bitFor(num))
+                _out << num;
+        _out << "}\n";
+    }
+    void searched(unsigned attempts, bool solved) {
+        _out << "backtrack: " << attempts << " attempt(s), "
+             << (solved ? "solved" : "no solution") << '\n';
+    }
+private:
+    std::ostream & _out;
+
+    void _cell(unsigned cell) {
+        _out << 'R' << cell / 9 + 1 << 'C' << cell % 9 + 1;
+    }
+};
+
+#endif
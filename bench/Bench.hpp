@@ -0,0 +1,53 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// What the programs in bench/ share: the clock they time with and loading
+// a puzzle file.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "../PuzzleIO.hpp"
+#include "../Solver.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+// Nanoseconds from `since` until now
+static inline double elapsed_ns(Clock::time_point since) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - since).count();
+}
+
+// Appends the 81 cells of every puzzle in `name`, in either format
+// PuzzleParser reads, to `puzzles`; malformed ones are skipped. Returns
+// false if the file cannot be opened.
+static inline bool load_puzzles(const char * name, std::vector<unsigned char> & puzzles) {
+    std::FILE * in = std::fopen(name, "rb");
+    if (!in)
+        return false;
+    LineReader reader(in);
+    PuzzleParser parser;
+    unsigned char cells[81];
+    PuzzleParser::status status;
+    while ((status = parser.next(reader, cells)) != PuzzleParser::MORE)
+        if (status == PuzzleParser::PUZZLE)
+            puzzles.insert(puzzles.end(), cells, cells + 81);
+    std::fclose(in);
+    return true;
+}
+
+// Appends a board for every puzzle in `name` whose givens do not clash.
+// Returns false if the file cannot be opened.
+static inline bool load_boards(const char * name, std::vector<Board> & boards) {
+    std::vector<unsigned char> puzzles;
+    if (!load_puzzles(name, puzzles))
+        return false;
+    for (std::size_t p = 0; p < puzzles.size(); p += 81) {
+        Board board;
+        if (load_cells(&puzzles[p], board))
+            boards.push_back(board);
+    }
+    return true;
+}
+
+#endif
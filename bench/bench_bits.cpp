@@ -0,0 +1,76 @@
+// Measures the bit-operation layer on its own and across the solver
+// pipeline. Build it twice to compare the intrinsics with the loops:
+//
+//   g++ -O2 -DNDEBUG bench/bench_bits.cpp -o bench_bits
+//   g++ -O2 -DNDEBUG -DSUDOKU_PORTABLE_BITS bench/bench_bits.cpp -o bench_bits_portable
+//   ./bench_bits bench/puzzles/hard.txt
+//
+// Pass -mpopcnt (or -march=native) to let GCC emit a popcnt instruction.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.hpp"
+
+static void bench_ops() {
+    const unsigned rounds = 200000;
+    unsigned sink = 0;
+    Clock::time_point start = Clock::now();
+    for (unsigned r = 0; r < rounds; ++r)
+        for (bitfield bits = r & 1; bits < maskMax; ++bits)
+            sink += bitCount(bits);
+    double count_ns = elapsed_ns(start) / (rounds * 512.0);
+
+    start = Clock::now();
+    for (unsigned r = 0; r < rounds; ++r)
+        for (unsigned num = 1 + (r & 1); num <= 9; ++num)
+            sink += numFor(bitFor(num));
+    double num_ns = elapsed_ns(start) / (rounds * 9.0);
+
+    std::printf("bitCount %.2f ns/op, numFor %.2f ns/op (%u)\n", count_ns, num_ns, sink & 1);
+}
+
+static void bench_pipeline(const std::vector<unsigned char> & puzzles, unsigned rounds) {
+    unsigned count = static_cast<unsigned>(puzzles.size() / 81);
+    double hidden = 0, advanced = 0, search = 0;
+    unsigned solved = 0;
+    for (unsigned r = 0; r < rounds; ++r)
+        for (unsigned p = 0; p < count; ++p) {
+            Board board;
+            load_cells(&puzzles[81 * p], board);
+            Clock::time_point start = Clock::now();
+            board.hidden_fill();
+            hidden += elapsed_ns(start);
+            start = Clock::now();
+            if (board.remaining())
+                board.advanced_fill();
+            advanced += elapsed_ns(start);
+            start = Clock::now();
+            if (board.remaining())
+                board.backtrack();
+            search += elapsed_ns(start);
+            solved += board.remaining() == 0;
+        }
+    double n = 1000.0 * rounds * count;
+    std::printf("hidden_fill %.1f us, advanced_fill %.1f us, backtrack %.1f us, "
+                "total %.1f us per puzzle (%u/%u solved)\n",
+                hidden / n, advanced / n, search / n, (hidden + advanced + search) / n,
+                solved, rounds * count);
+}
+
+int main(int argc, char * argv[]) {
+    std::printf("bits: %s, simd: %s\n", SUDOKU_BITS, SUDOKU_SIMD);
+    bench_ops();
+    if (argc < 2)
+        return 0;
+
+    std::vector<unsigned char> puzzles;
+    if (!load_puzzles(argv[1], puzzles)) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    unsigned rounds = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 10;
+    bench_pipeline(puzzles, rounds);
+    return 0;
+}
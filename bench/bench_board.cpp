@@ -0,0 +1,58 @@
+// Measures what the board layout costs: the size of a Board, the time to
+// copy one (the generator copies a board for every trial) and the time to
+// solve a copy of each puzzle in a file:
+//
+//   g++ -O2 -DNDEBUG -mpopcnt bench/bench_board.cpp -o bench_board
+//   ./bench_board bench/puzzles/hard.txt [rounds]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.hpp"
+
+static void bench_copy(const std::vector<Board> & boards) {
+    // Cycle through more boards than fit in L1 so the copies touch memory
+    // the way the generator's trial boards do
+    const unsigned rounds = 2000000;
+    std::vector<Board> copies(boards.size(), Board());
+    unsigned sink = 0;
+    Clock::time_point start = Clock::now();
+    for (unsigned r = 0; r < rounds; ++r) {
+        unsigned k = r % boards.size();
+        copies[k] = boards[k];
+        sink += copies[k].get_num(r % 9, 0);
+    }
+    std::printf("copy %.1f ns/board (%u)\n", elapsed_ns(start) / rounds, sink & 1);
+}
+
+static void bench_solve(const std::vector<Board> & boards, unsigned rounds) {
+    unsigned solved = 0;
+    Clock::time_point start = Clock::now();
+    for (unsigned r = 0; r < rounds; ++r)
+        for (unsigned k = 0; k < boards.size(); ++k) {
+            Board board = boards[k];
+            solved += solve_board(board);
+        }
+    std::printf("copy + solve %.1f us/puzzle (%u/%u solved)\n",
+                elapsed_ns(start) / (1000.0 * rounds * boards.size()), solved,
+                static_cast<unsigned>(rounds * boards.size()));
+}
+
+int main(int argc, char * argv[]) {
+    std::printf("sizeof(Board) = %u bytes\n", static_cast<unsigned>(sizeof(Board)));
+    if (argc < 2)
+        return 0;
+
+    std::vector<Board> boards;
+    if (!load_boards(argv[1], boards)) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    if (boards.empty())
+        return 0;
+    unsigned rounds = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 10;
+    bench_copy(boards);
+    bench_solve(boards, rounds);
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Compares the solving engines on the same puzzle files:
+//
+//   g++ -O2 -DNDEBUG -mpopcnt bench/bench_engines.cpp -o bench_engines
+//   ./bench_engines bench/puzzles/hard.txt more.txt ...
+//
+// For every file and engine it prints the mean, 99th percentile and worst
+// solve time per puzzle.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Bench.hpp"
+
+static void bench(const char * name, const std::vector<unsigned char> & puzzles,
+                  engine e, unsigned rounds) {
+    unsigned count = static_cast<unsigned>(puzzles.size() / 81);
+    std::vector<double> times;
+    unsigned solved = 0;
+    for (unsigned r = 0; r < rounds; ++r)
+        for (unsigned p = 0; p < count; ++p) {
+            Clock::time_point start = Clock::now();
+            Board board;
+            solved += load_cells(&puzzles[81 * p], board) && solve_board(board, e);
+            times.push_back(elapsed_ns(start) / 1e3);
+        }
+    if (times.empty())
+        return;
+    double total = 0;
+    for (unsigned k = 0; k < times.size(); ++k)
+        total += times[k];
+    std::sort(times.begin(), times.end());
+    std::printf("%-28s %-8s mean %9.1f us  p99 %9.1f us  max %9.1f us  (%u/%u solved)\n",
+                name, engine_name(e), total / times.size(),
+                times[times.size() * 99 / 100], times.back(),
+                solved, static_cast<unsigned>(times.size()));
+}
+
+int main(int argc, char * argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s puzzles.txt... [-r rounds]\n", argv[0]);
+        return 1;
+    }
+    unsigned rounds = 5;
+    for (int k = 1; k < argc; ++k)
+        if (std::strcmp(argv[k], "-r") == 0 && k + 1 < argc)
+            rounds = static_cast<unsigned>(std::atoi(argv[k + 1]));
+    for (int k = 1; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-r") == 0) {
+            ++k;
+            continue;
+        }
+        std::vector<unsigned char> puzzles;
+        if (!load_puzzles(argv[k], puzzles)) {
+            std::fprintf(stderr, "Cannot open %s\n", argv[k]);
+            return 1;
+        }
+        bench(argv[k], puzzles, PIPELINE, rounds);
+        bench(argv[k], puzzles, EXTENDED, rounds);
+        bench(argv[k], puzzles, DANCING_LINKS, rounds);
+    }
+    return 0;
+}
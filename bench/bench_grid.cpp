@@ -0,0 +1,45 @@
+// Measures complete-grid generation, the first step of every generated
+// puzzle:
+//
+//   g++ -O2 -DNDEBUG -mpopcnt bench/bench_grid.cpp -o bench_grid
+//   ./bench_grid [count] [seed]
+//
+// Every grid is checked to be complete and valid.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "Bench.hpp"
+
+static bool valid_grid(Board & board) {
+    for (unsigned k = 0; k < 9; ++k) {
+        bitfield row = 0, col = 0, block = 0;
+        for (unsigned m = 0; m < 9; ++m) {
+            unsigned r = k / 3 * 3 + m / 3, c = k % 3 * 3 + m % 3;
+            if (!board.get_num(k, m) || !board.get_num(m, k) || !board.get_num(r, c))
+                return false;
+            row |= bitFor(board.get_num(k, m));
+            col |= bitFor(board.get_num(m, k));
+            block |= bitFor(board.get_num(r, c));
+        }
+        if (row != allSet || col != allSet || block != allSet)
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char * argv[]) {
+    unsigned count = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 100000;
+    unsigned long long seed = argc > 2 ? std::strtoull(argv[2], 0, 10) : 1;
+    Random rng(seed);
+    unsigned valid = 0;
+    Clock::time_point start = Clock::now();
+    for (unsigned k = 0; k < count; ++k) {
+        Board grid(rng);
+        valid += valid_grid(grid);
+    }
+    double seconds = elapsed_ns(start) / 1e9;
+    std::printf("%u grids in %.3f s: %.0f grids/s, %.2f us/grid (%u/%u valid)\n",
+                count, seconds, count / seconds, 1e6 * seconds / count, valid, count);
+    return valid == count ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// A load generator for `Sudoku -S`: keeps a number of connections busy
+// with pipelined requests for a while and reports throughput and latency:
+//
+//   g++ -O2 -DNDEBUG -mpopcnt -pthread bench/bench_server.cpp -o bench_server
+//   ./Sudoku -S &
+//   ./bench_server -c 8 -d 16 bench/puzzles/hard.txt
+//
+// Options: -p PORT or -u SOCKET picks the server (127.0.0.1:9081 by
+// default), -c N opens N connections (default 4), -d N keeps N requests in
+// flight on each (default 16), -t S runs for S seconds (default 2), and -o
+// OP sends solve, validate, rate or hint requests for the puzzles in the
+// file (solve by default), or generate requests for the level named by the
+// file argument instead. It prints one JSON line like bench_suite's with
+// requests per second and the p50, p90, p99 and max latency from a request
+// being sent to its reply arriving, and counts "err" replies.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../Stats.hpp"
+#include "Bench.hpp"
+
+struct Options {
+    unsigned port;
+    const char * path;
+    unsigned depth;
+    double seconds;
+};
+
+struct Load {
+    Histogram ns;
+    unsigned long errors;
+    bool failed;
+};
+
+static int connect_to(const Options & options) {
+    if (options.path) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, options.path, sizeof address.sun_path - 1);
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof address) == 0)
+            return fd;
+        if (fd >= 0)
+            ::close(fd);
+        return -1;
+    }
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof address);
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<unsigned short>(options.port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof address) == 0) {
+        int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+        return fd;
+    }
+    if (fd >= 0)
+        ::close(fd);
+    return -1;
+}
+
+static bool send_all(int fd, const char * data, std::size_t size) {
+    while (size) {
+        ssize_t put = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (put <= 0)
+            return false;
+        data += put;
+        size -= static_cast<std::size_t>(put);
+    }
+    return true;
+}
+
+// One connection: sends requests round-robin from `requests`, topping the
+// window up to `depth` whenever a reply comes back, until time runs out,
+// then waits for the rest. Replies arrive in request order, so the send
+// times form a ring.
+static void drive(const Options & options, const std::vector<std::string> & requests,
+                  unsigned offset, Load & load) {
+    load.errors = 0;
+    load.failed = false;
+    int fd = connect_to(options);
+    if (fd < 0) {
+        load.failed = true;
+        return;
+    }
+    std::vector<Clock::time_point> sent(options.depth);
+    unsigned long issued = 0, answered = 0;
+    std::size_t next = offset % requests.size();
+    Clock::time_point stop = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.seconds));
+    std::string batch;
+    char buffer[1 << 16];
+    std::size_t size = 0;
+    bool sending = true;
+    while (true) {
+        if (sending && Clock::now() >= stop)
+            sending = false;
+        if (!sending && answered == issued)
+            break;
+        batch.clear();
+        Clock::time_point now = Clock::now();
+        while (sending && issued - answered < options.depth) {
+            batch += requests[next];
+            next = (next + 1) % requests.size();
+            sent[issued++ % options.depth] = now;
+        }
+        if (!batch.empty() && !send_all(fd, batch.data(), batch.size())) {
+            load.failed = true;
+            break;
+        }
+        ssize_t got = ::recv(fd, buffer + size, sizeof buffer - size, 0);
+        if (got <= 0) {
+            load.failed = true;
+            break;
+        }
+        size += static_cast<std::size_t>(got);
+        now = Clock::now();
+        std::size_t start = 0;
+        while (const char * newline = static_cast<const char *>(
+                   std::memchr(buffer + start, '\n', size - start))) {
+            if (std::strncmp(buffer + start, "ok", 2) != 0)
+                ++load.errors;
+            load.ns.record(static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - sent[answered++ % options.depth]).count()));
+            start = static_cast<std::size_t>(newline - buffer) + 1;
+        }
+        std::memmove(buffer, buffer + start, size - start);
+        size -= start;
+    }
+    ::close(fd);
+}
+
+int main(int argc, char * argv[]) {
+    Options options = { 9081, 0, 16, 2.0 };
+    unsigned connections = 4;
+    const char * op = "solve";
+    const char * source = "bench/puzzles/hard.txt";
+    for (int k = 1; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-p") == 0 && k + 1 < argc) {
+            options.port = static_cast<unsigned>(std::atoi(argv[++k]));
+        } else if (std::strcmp(argv[k], "-u") == 0 && k + 1 < argc) {
+            options.path = argv[++k];
+        } else if (std::strcmp(argv[k], "-c") == 0 && k + 1 < argc) {
+            connections = static_cast<unsigned>(std::atoi(argv[++k]));
+        } else if (std::strcmp(argv[k], "-d") == 0 && k + 1 < argc) {
+            options.depth = static_cast<unsigned>(std::atoi(argv[++k]));
+        } else if (std::strcmp(argv[k], "-t") == 0 && k + 1 < argc) {
+            options.seconds = std::atof(argv[++k]);
+        } else if (std::strcmp(argv[k], "-o") == 0 && k + 1 < argc) {
+            op = argv[++k];
+        } else if (argv[k][0] == '-') {
+            std::fprintf(stderr, "Unknown option %s\n", argv[k]);
+            return 1;
+        } else {
+            source = argv[k];
+        }
+    }
+    if (!connections || !options.depth) {
+        std::fprintf(stderr, "-c and -d must be at least 1\n");
+        return 1;
+    }
+
+    std::vector<std::string> requests;
+    if (std::strcmp(op, "generate") == 0) {
+        requests.push_back(std::string("generate ") + source + "\n");
+    } else {
+        std::vector<unsigned char> puzzles;
+        if (!load_puzzles(source, puzzles)) {
+            std::fprintf(stderr, "Cannot read %s\n", source);
+            return 1;
+        }
+        char text[82];
+        for (std::size_t p = 0; p < puzzles.size(); p += 81) {
+            format_line(&puzzles[p], text);
+            requests.push_back(std::string(op) + " " + std::string(text, 82));
+        }
+        if (requests.empty()) {
+            std::fprintf(stderr, "No puzzles in %s\n", source);
+            return 1;
+        }
+    }
+
+    std::vector<Load> loads(connections);
+    std::vector<std::thread> threads;
+    Clock::time_point start = Clock::now();
+    for (unsigned k = 0; k < connections; ++k)
+        threads.push_back(std::thread(drive, std::cref(options), std::cref(requests),
+                                      k * 7, std::ref(loads[k])));
+    for (unsigned k = 0; k < connections; ++k)
+        threads[k].join();
+    double elapsed = elapsed_ns(start) / 1e9;
+
+    Histogram ns;
+    unsigned long errors = 0;
+    for (unsigned k = 0; k < connections; ++k) {
+        if (loads[k].failed) {
+            std::fprintf(stderr, "Connection %u to the server failed\n", k);
+            return 1;
+        }
+        ns.add(loads[k].ns);
+        errors += loads[k].errors;
+    }
+    std::printf("{\"bench\":\"server\",\"op\":\"%s\",\"connections\":%u,\"depth\":%u,"
+                "\"count\":%llu,\"errors\":%lu,\"per_sec\":%.1f,\"p50_us\":%.2f,"
+                "\"p90_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f}\n",
+                op, connections, options.depth, ns.count(), errors, ns.count() / elapsed,
+                ns.percentile(0.5) / 1e3, ns.percentile(0.9) / 1e3,
+                ns.percentile(0.99) / 1e3, ns.max() / 1e3);
+    return 0;
+}
@@ -0,0 +1,227 @@
+// The benchmark suite: times what Sudoku does with a puzzle on the checked-in
+// corpora, and the generator at every level, and prints one JSON object per
+// line so runs can be compared between commits:
+//
+//   g++ -O2 -DNDEBUG -mpopcnt -pthread bench/bench_suite.cpp -o bench_suite
+//   ./bench_suite > before.jsonl
+//   ./bench_suite -c before.jsonl > after.jsonl
+//
+// Options: -p DIR reads the corpora from DIR (default bench/puzzles), -t S
+// repeats each measurement until it has run for S seconds (default 0.5),
+// and -c FILE prints the change in throughput against an earlier run to
+// stderr. The operations mirror the Sudoku class:
+//
+//   solve          solve_board on a copy (Sudoku::solve)
+//   has_solution   count_solutions(2), then solve (Sudoku::_has_solution)
+//   partial_solve  hidden_fill, then advanced_fill with every technique
+//                  (Sudoku::partial_solve)
+//   cached         PuzzleCache::solve once the warm-up has filled the cache,
+//                  so every lookup hits (Sudoku -b -c)
+//   hints          a whole game played by taking every hint (Sudoku::next_step)
+//   generate       generate_puzzle, one level per row (Sudoku::generate)
+//
+// Generated puzzles come from fixed seeds, so every run does the same work.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../Generator.hpp"
+#include "../Hints.hpp"
+#include "../PuzzleCache.hpp"
+#include "Bench.hpp"
+
+static const char * const corpora[] = { "easy", "evil", "17clue", "hard" };
+
+struct Result {
+    std::string bench, set;
+    unsigned long count;
+    double per_sec, mean, p50, p90, p99, max;
+};
+
+static double percentile(const std::vector<double> & sorted, double q) {
+    return sorted[std::min<std::size_t>(sorted.size() - 1,
+                                        static_cast<std::size_t>(q * sorted.size()))];
+}
+
+// Runs `op` on items 0..n-1 round after round until `seconds` have passed,
+// after one untimed warm-up round, and summarizes the per-item latencies
+template <class Op>
+static Result measure(const char * bench, const char * set, unsigned n, double seconds, Op op) {
+    std::vector<double> times;
+    unsigned sink = 0;
+    for (unsigned k = 0; k < n; ++k)
+        sink += op(k);
+    double elapsed = 0;
+    while (elapsed < seconds)
+        for (unsigned k = 0; k < n; ++k) {
+            Clock::time_point start = Clock::now();
+            sink += op(k);
+            double us = elapsed_ns(start) / 1e3;
+            times.push_back(us);
+            elapsed += us / 1e6;
+        }
+    std::sort(times.begin(), times.end());
+    double total = 0;
+    for (std::size_t k = 0; k < times.size(); ++k)
+        total += times[k];
+    Result r;
+    r.bench = bench;
+    r.set = set;
+    r.count = static_cast<unsigned long>(times.size());
+    r.per_sec = times.size() / (total / 1e6);
+    r.mean = total / times.size();
+    r.p50 = percentile(times, 0.5);
+    r.p90 = percentile(times, 0.9);
+    r.p99 = percentile(times, 0.99);
+    r.max = times.back();
+    if (sink == 0xFFFFFFFFu)
+        std::fprintf(stderr, "%u\n", sink);
+    return r;
+}
+
+static void print(const Result & r) {
+    std::printf("{\"bench\":\"%s\",\"set\":\"%s\",\"count\":%lu,\"per_sec\":%.1f,"
+                "\"mean_us\":%.2f,\"p50_us\":%.2f,\"p90_us\":%.2f,\"p99_us\":%.2f,"
+                "\"max_us\":%.2f}\n",
+                r.bench.c_str(), r.set.c_str(), r.count, r.per_sec,
+                r.mean, r.p50, r.p90, r.p99, r.max);
+    std::fflush(stdout);
+}
+
+// Reads the rows of an earlier run; anything else in the file is skipped
+static std::vector<Result> read_results(const char * name) {
+    std::vector<Result> results;
+    std::FILE * in = std::fopen(name, "r");
+    if (!in)
+        return results;
+    char line[512], bench[64], set[64];
+    while (std::fgets(line, sizeof line, in)) {
+        Result r;
+        if (std::sscanf(line, "{\"bench\":\"%63[^\"]\",\"set\":\"%63[^\"]\",\"count\":%lu,"
+                        "\"per_sec\":%lf,\"mean_us\":%lf,\"p50_us\":%lf,\"p90_us\":%lf,"
+                        "\"p99_us\":%lf,\"max_us\":%lf}",
+                        bench, set, &r.count, &r.per_sec, &r.mean, &r.p50, &r.p90,
+                        &r.p99, &r.max) != 9)
+            continue;
+        r.bench = bench;
+        r.set = set;
+        results.push_back(r);
+    }
+    std::fclose(in);
+    return results;
+}
+
+static void compare(const std::vector<Result> & before, const std::vector<Result> & after) {
+    std::fprintf(stderr, "%-14s %-10s %12s %12s %8s %10s %10s\n", "bench", "set",
+                 "before/s", "after/s", "change", "p99 before", "p99 after");
+    for (std::size_t a = 0; a < after.size(); ++a)
+        for (std::size_t b = 0; b < before.size(); ++b)
+            if (before[b].bench == after[a].bench && before[b].set == after[a].set)
+                std::fprintf(stderr, "%-14s %-10s %12.1f %12.1f %+7.1f%% %10.2f %10.2f\n",
+                             after[a].bench.c_str(), after[a].set.c_str(),
+                             before[b].per_sec, after[a].per_sec,
+                             100.0 * (after[a].per_sec / before[b].per_sec - 1),
+                             before[b].p99, after[a].p99);
+}
+
+int main(int argc, char * argv[]) {
+    std::string dir = "bench/puzzles";
+    double seconds = 0.5;
+    const char * baseline = 0;
+    for (int k = 1; k < argc; ++k) {
+        if (std::strcmp(argv[k], "-p") == 0 && k + 1 < argc) {
+            dir = argv[++k];
+        } else if (std::strcmp(argv[k], "-t") == 0 && k + 1 < argc) {
+            seconds = std::atof(argv[++k]);
+        } else if (std::strcmp(argv[k], "-c") == 0 && k + 1 < argc) {
+            baseline = argv[++k];
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", argv[k]);
+            return 1;
+        }
+    }
+
+    std::printf("{\"bench\":\"meta\",\"compiler\":\"%s\",\"simd\":\"%s\",\"seconds\":%.2f}\n",
+                __VERSION__, SUDOKU_SIMD, seconds);
+    std::vector<Result> results;
+    for (unsigned c = 0; c < sizeof corpora / sizeof *corpora; ++c) {
+        std::vector<Board> boards;
+        if (!load_boards((dir + "/" + corpora[c] + ".txt").c_str(), boards) || boards.empty()) {
+            std::fprintf(stderr, "Cannot read %s/%s.txt\n", dir.c_str(), corpora[c]);
+            return 1;
+        }
+        unsigned n = static_cast<unsigned>(boards.size());
+        results.push_back(measure("solve", corpora[c], n, seconds, [&boards](unsigned k) {
+            Board board = boards[k];
+            return static_cast<unsigned>(solve_board(board));
+        }));
+        print(results.back());
+        results.push_back(measure("has_solution", corpora[c], n, seconds, [&boards](unsigned k) {
+            Board board = boards[k];
+            unsigned found = board.count_solutions(2);
+            if (found)
+                solve_board(board);
+            return found;
+        }));
+        print(results.back());
+        results.push_back(measure("partial_solve", corpora[c], n, seconds, [&boards](unsigned k) {
+            Board board = boards[k];
+            board.hidden_fill();
+            if (board.remaining())
+                board.advanced_fill(false, SWORDFISH);
+            return board.remaining();
+        }));
+        print(results.back());
+        std::vector<unsigned char> cells(81 * n);
+        for (unsigned k = 0; k < n; ++k)
+            for (unsigned m = 0; m < 81; ++m)
+                cells[81 * k + m] = static_cast<unsigned char>(boards[k].get_num(m / 9, m % 9));
+        PuzzleCache cache(2 * n);
+        results.push_back(measure("cached", corpora[c], n, seconds, [&cells, &cache](unsigned k) {
+            PuzzleFacts facts;
+            cache.solve(&cells[81 * k], facts);
+            return facts.solutions;
+        }));
+        print(results.back());
+        std::vector<Board> answers(boards);
+        for (unsigned k = 0; k < n; ++k)
+            solve_board(answers[k]);
+        results.push_back(measure("hints", corpora[c], n, seconds, [&boards, &answers](unsigned k) {
+            HintEngine hints;
+            hints.start(boards[k], answers[k]);
+            Hint hint;
+            unsigned taken = 0;
+            for (; hints.next(hint); ++taken)
+                hints.play(hint.row, hint.col, hint.val);
+            return taken;
+        }));
+        print(results.back());
+    }
+    // A fixed pool of puzzle indices per level; every round regenerates them
+    const unsigned generated = 32;
+    for (unsigned l = EASY; l <= EVIL; ++l) {
+        difficulty level = static_cast<difficulty>(l);
+        results.push_back(measure("generate", difficulty_name(level), generated, seconds,
+                                  [level](unsigned k) {
+            Random rng = puzzle_random(1, level, k);
+            Board puzzle, answer;
+            generate_puzzle(level, rng, puzzle, answer);
+            return puzzle.remaining();
+        }));
+        print(results.back());
+    }
+
+    if (baseline) {
+        std::vector<Result> before = read_results(baseline);
+        if (before.empty()) {
+            std::fprintf(stderr, "No results in %s\n", baseline);
+            return 1;
+        }
+        compare(before, results);
+    }
+    return 0;
+}
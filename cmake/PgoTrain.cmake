@@ -0,0 +1,25 @@
+# Runs the instrumented programs over the benchmark corpora so that
+# -fprofile-generate records a profile. Invoked by the pgo-train target:
+#
+#   cmake -DSUDOKU=<Sudoku> -DBENCH_SUITE=<bench_suite or empty>
+#         -DPUZZLES=<dir> -DPROFILE_DIR=<build dir> -P PgoTrain.cmake
+
+# Start from a clean profile rather than adding to the last one
+file(GLOB_RECURSE old_profiles "${PROFILE_DIR}/*.gcda")
+if(old_profiles)
+    file(REMOVE ${old_profiles})
+endif()
+
+foreach(set easy evil 17clue hard)
+    execute_process(COMMAND "${SUDOKU}" -b -j 1 "${PUZZLES}/${set}.txt"
+                    OUTPUT_QUIET RESULT_VARIABLE failed)
+    if(failed)
+        message(FATAL_ERROR "Training on ${set}.txt failed")
+    endif()
+endforeach()
+execute_process(COMMAND "${SUDOKU}" -b -j 1 -l "${PUZZLES}/easy.txt" OUTPUT_QUIET)
+execute_process(COMMAND "${SUDOKU}" -g -j 1 -n 16 -s 1 OUTPUT_QUIET)
+if(BENCH_SUITE)
+    execute_process(COMMAND "${BENCH_SUITE}" -p "${PUZZLES}" -t 0.05
+                    OUTPUT_QUIET ERROR_QUIET)
+endif()
@@ -0,0 +1,223 @@
+// Checks the sudoku_core entry points end to end: solving with each engine,
+// counting solutions, rating, hinting, generating and stream solving, and
+// that each of them turns down clashing givens. Prints every failed check
+// and exits non-zero if there was one. Registered with CTest as "core".
+
+#include <cstdio>
+#include <cstring>
+
+#include "SudokuCore.hpp"
+
+static unsigned failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++failures; \
+        } \
+    } while (0)
+
+static const char hard[] =
+    "1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..";
+static const char hard_solution[] =
+    "162857493534129678789643521475312986913586742628794135356478219241935867897261354";
+
+static void read_cells(const char * text, unsigned char cells[81]) {
+    for (unsigned k = 0; k < 81; ++k)
+        cells[k] = static_cast<unsigned char>(text[k] == '.' ? 0 : text[k] - '0');
+}
+
+// Whether `answer` is a complete grid that keeps the givens of `puzzle`
+static bool solves(const unsigned char puzzle[81], const unsigned char answer[81]) {
+    unsigned rows[9] = {0}, cols[9] = {0}, boxes[9] = {0};
+    for (unsigned k = 0; k < 81; ++k) {
+        unsigned i = k / 9, j = k % 9, b = i / 3 * 3 + j / 3;
+        if (answer[k] < 1 || answer[k] > 9 || (puzzle[k] && puzzle[k] != answer[k]))
+            return false;
+        unsigned bit = 1u << answer[k];
+        if ((rows[i] | cols[j] | boxes[b]) & bit)
+            return false;
+        rows[i] |= bit;
+        cols[j] |= bit;
+        boxes[b] |= bit;
+    }
+    return true;
+}
+
+static unsigned blanks(const unsigned char puzzle[81]) {
+    unsigned count = 0;
+    for (unsigned k = 0; k < 81; ++k)
+        count += !puzzle[k];
+    return count;
+}
+
+static void test_solve() {
+    unsigned char puzzle[81], expected[81], answer[81];
+    read_cells(hard, puzzle);
+    read_cells(hard_solution, expected);
+    const SudokuEngine engines[] = { SUDOKU_PIPELINE, SUDOKU_DANCING_LINKS, SUDOKU_EXTENDED };
+    for (unsigned e = 0; e < 3; ++e) {
+        std::memset(answer, 0, 81);
+        CHECK(sudoku_solve(puzzle, answer, engines[e]));
+        CHECK(std::memcmp(answer, expected, 81) == 0);
+    }
+    // In place
+    std::memcpy(answer, puzzle, 81);
+    CHECK(sudoku_solve(answer, answer));
+    CHECK(std::memcmp(answer, expected, 81) == 0);
+
+    unsigned char clash[81];
+    std::memcpy(clash, puzzle, 81);
+    clash[1] = 1;
+    CHECK(!sudoku_solve(clash, answer));
+}
+
+static void test_count_solutions() {
+    unsigned char puzzle[81];
+    read_cells(hard, puzzle);
+    CHECK(sudoku_count_solutions(puzzle) == 1);
+
+    unsigned char empty[81] = {0};
+    CHECK(sudoku_count_solutions(empty) == 2);
+    CHECK(sudoku_count_solutions(empty, 5) == 5);
+
+    unsigned char clash[81];
+    std::memcpy(clash, puzzle, 81);
+    clash[1] = 1;
+    CHECK(sudoku_count_solutions(clash) == 0);
+}
+
+static void test_rate() {
+    unsigned char puzzle[81];
+    read_cells(hard, puzzle);
+    SudokuRating rating;
+    CHECK(sudoku_rate(puzzle, rating));
+    CHECK(rating.singles + rating.advanced + rating.search == blanks(puzzle));
+    CHECK(rating.level >= SUDOKU_EASY && rating.level <= SUDOKU_EVIL);
+
+    unsigned char clash[81];
+    std::memcpy(clash, puzzle, 81);
+    clash[1] = 1;
+    SudokuRating untouched = { SUDOKU_DEFAULT, 7, 7, 7 };
+    CHECK(!sudoku_rate(clash, untouched));
+    CHECK(untouched.singles == 7 && untouched.level == SUDOKU_DEFAULT);
+}
+
+static void test_hint() {
+    unsigned char puzzle[81], expected[81];
+    read_cells(hard, puzzle);
+    read_cells(hard_solution, expected);
+    // Following the hints to the end fills in the solution, one cell a step
+    unsigned open = blanks(puzzle), steps = 0;
+    SudokuHint hint;
+    while (sudoku_hint(puzzle, hint)) {
+        unsigned k = 9 * hint.row + hint.col;
+        CHECK(hint.row < 9 && hint.col < 9 && !puzzle[k]);
+        CHECK(hint.val == expected[k]);
+        char cell[8];
+        std::snprintf(cell, sizeof cell, "R%uC%u=%u", hint.row + 1, hint.col + 1, hint.val);
+        CHECK(std::strncmp(hint.text, cell, std::strlen(cell)) == 0);
+        if (puzzle[k] || hint.val != expected[k])
+            break;
+        puzzle[k] = static_cast<unsigned char>(hint.val);
+        ++steps;
+    }
+    CHECK(steps == open);
+    CHECK(std::memcmp(puzzle, expected, 81) == 0);
+
+    unsigned char empty[81] = {0};
+    CHECK(!sudoku_hint(empty, hint));
+}
+
+static void test_generate() {
+    const SudokuLevel levels[] = { SUDOKU_EASY, SUDOKU_MEDIUM, SUDOKU_DIFFICULT, SUDOKU_EVIL };
+    for (unsigned l = 0; l < 4; ++l) {
+        unsigned char puzzle[81], answer[81], again[81], solved[81];
+        sudoku_generate(levels[l], 5, l, puzzle, answer);
+        CHECK(solves(puzzle, answer));
+        CHECK(sudoku_count_solutions(puzzle) == 1);
+        CHECK(sudoku_solve(puzzle, solved));
+        CHECK(std::memcmp(solved, answer, 81) == 0);
+        SudokuRating rating;
+        CHECK(sudoku_rate(puzzle, rating));
+        CHECK(rating.singles + rating.advanced + rating.search == blanks(puzzle));
+        // The same seed and index give the same puzzle
+        sudoku_generate(levels[l], 5, l, again, solved);
+        CHECK(std::memcmp(again, puzzle, 81) == 0);
+    }
+}
+
+static void test_solve_stream() {
+    std::FILE * in = std::tmpfile();
+    std::FILE * out = std::tmpfile();
+    std::FILE * err = std::tmpfile();
+    if (!in || !out || !err) {
+        CHECK(!"cannot open temporary files");
+        return;
+    }
+    std::fprintf(in, "%s\n# a comment\n\nnot a puzzle\n%s\n", hard, hard);
+    std::rewind(in);
+    CHECK(sudoku_solve_stream(in, out, err, 2) == 1);
+    std::rewind(out);
+    char line[128];
+    unsigned solved = 0, empty = 0;
+    while (std::fgets(line, sizeof line, out)) {
+        if (std::strncmp(line, hard_solution, 81) == 0)
+            ++solved;
+        else if (line[0] == '\n')
+            ++empty;
+    }
+    CHECK(solved == 2);
+    CHECK(empty == 1);
+    std::fclose(in);
+    std::fclose(out);
+    std::fclose(err);
+}
+
+// A line cut short among one-line puzzles costs only itself: the puzzles
+// after it are not taken for the rows of a grid
+static void test_solve_stream_truncated() {
+    std::FILE * in = std::tmpfile();
+    std::FILE * out = std::tmpfile();
+    std::FILE * err = std::tmpfile();
+    if (!in || !out || !err) {
+        CHECK(!"cannot open temporary files");
+        return;
+    }
+    std::fprintf(in, "%s\n%.9s\n", hard, hard);
+    for (unsigned p = 0; p < 10; ++p)
+        std::fprintf(in, "%s\n", hard);
+    std::fprintf(in, "%.40s\n%s\n", hard, hard);
+    std::rewind(in);
+    CHECK(sudoku_solve_stream(in, out, err) == 2);
+    std::rewind(out);
+    char line[128];
+    unsigned lines = 0, solved = 0, empty = 0;
+    while (std::fgets(line, sizeof line, out)) {
+        ++lines;
+        if (std::strncmp(line, hard_solution, 81) == 0)
+            ++solved;
+        else if (line[0] == '\n')
+            ++empty;
+    }
+    CHECK(lines == 14);
+    CHECK(solved == 12);
+    CHECK(empty == 2);
+    std::fclose(in);
+    std::fclose(out);
+    std::fclose(err);
+}
+
+int main() {
+    test_solve();
+    test_count_solutions();
+    test_rate();
+    test_hint();
+    test_generate();
+    test_solve_stream();
+    test_solve_stream_truncated();
+    if (failures)
+        std::fprintf(stderr, "%u check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}